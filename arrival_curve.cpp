@@ -0,0 +1,170 @@
+#include "arrival_curve.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <numbers>
+
+#include "utils.h"
+
+namespace
+{
+
+auto parse_double(std::string_view text, double &out) -> bool
+{
+    return parse_number(trim(text), out) && std::isfinite(out);
+}
+
+// Up to `fields.size()` comma-separated numbers; at least `required` of them
+template <std::size_t N>
+auto parse_fields(std::string_view text, std::array<double *, N> fields, std::size_t required) -> bool
+{
+    for (std::size_t count = 0; count < N; ++count)
+    {
+        auto comma = text.find(',');
+        if (!parse_double(text.substr(0, comma), *fields[count]))
+            return false;
+        if (comma == std::string_view::npos)
+            return count + 1 >= required;
+        text = text.substr(comma + 1);
+    }
+    return false;
+}
+
+// Spikes only ever decay, so their sum peaks at some spike's onset; dips are
+// left out, which keeps this an upper bound
+auto spike_bound(const std::vector<ArrivalCurve::Spike> &spikes) -> double
+{
+    double best = 1.0;
+    for (const ArrivalCurve::Spike &onset : spikes)
+    {
+        double sum = 1.0;
+        for (const ArrivalCurve::Spike &spike : spikes)
+        {
+            if (spike.at_s <= onset.at_s)
+                sum += std::max(spike.factor - 1.0, 0.0) * std::exp(-(onset.at_s - spike.at_s) / spike.decay_s);
+        }
+        best = std::max(best, sum);
+    }
+    return best;
+}
+
+} // namespace
+
+auto ArrivalCurve::multiplier(double t_s) const -> double
+{
+    double m = 1.0;
+    if (diurnal.amplitude > 0.0)
+        m *= 1.0 + diurnal.amplitude * std::cos(2.0 * std::numbers::pi * (t_s - diurnal.peak_s) / diurnal.period_s);
+
+    if (!points.empty())
+    {
+        auto after = std::upper_bound(points.begin(), points.end(), t_s,
+                                      [](double t, const Point &p) { return t < p.t_s; });
+        if (after == points.begin())
+            m *= after->multiplier;
+        else if (after == points.end())
+            m *= points.back().multiplier;
+        else
+        {
+            const Point &a = *(after - 1);
+            const Point &b = *after;
+            m *= a.multiplier + (b.multiplier - a.multiplier) * (t_s - a.t_s) / (b.t_s - a.t_s);
+        }
+    }
+
+    if (!spikes.empty())
+    {
+        double sum = 1.0;
+        for (const Spike &spike : spikes)
+        {
+            if (t_s >= spike.at_s)
+                sum += (spike.factor - 1.0) * std::exp(-(t_s - spike.at_s) / spike.decay_s);
+        }
+        m *= std::max(sum, 0.0);
+    }
+    return m;
+}
+
+auto ArrivalCurve::bound() const -> double
+{
+    double b = 1.0 + diurnal.amplitude;
+    if (!points.empty())
+    {
+        b *= std::max_element(points.begin(), points.end(), [](const Point &x, const Point &y)
+                              { return x.multiplier < y.multiplier; })
+                 ->multiplier;
+    }
+    return b * spike_bound(spikes);
+}
+
+auto parse_diurnal(std::string_view text, ArrivalCurve::Diurnal &out) -> bool
+{
+    ArrivalCurve::Diurnal d;
+    if (!parse_fields<3>(text, {&d.amplitude, &d.period_s, &d.peak_s}, 1))
+        return false;
+    if (d.amplitude < 0.0 || d.amplitude >= 1.0 || d.period_s <= 0.0)
+        return false;
+    out = d;
+    return true;
+}
+
+auto parse_spike(std::string_view text, ArrivalCurve::Spike &out) -> bool
+{
+    ArrivalCurve::Spike s;
+    if (!parse_fields<3>(text, {&s.at_s, &s.factor, &s.decay_s}, 2))
+        return false;
+    if (s.at_s < 0.0 || s.factor < 0.0 || s.decay_s <= 0.0)
+        return false;
+    out = s;
+    return true;
+}
+
+auto load_arrival_points(const std::string &path, std::vector<ArrivalCurve::Point> &points, std::string &error)
+    -> bool
+{
+    std::ifstream in(path);
+    if (!in)
+    {
+        error = "cannot open arrival curve " + path;
+        return false;
+    }
+
+    std::vector<ArrivalCurve::Point> loaded;
+    std::string raw;
+    int line_no = 0;
+    while (std::getline(in, raw))
+    {
+        ++line_no;
+        std::string_view line = raw;
+        if (auto hash = line.find('#'); hash != std::string_view::npos)
+            line = line.substr(0, hash);
+        line = trim(line);
+        if (line.empty())
+            continue;
+
+        auto gap = line.find_first_of(" \t,");
+        ArrivalCurve::Point point;
+        if (gap == std::string_view::npos || !parse_double(line.substr(0, gap), point.t_s) ||
+            !parse_double(trim(line.substr(gap + 1)), point.multiplier))
+        {
+            error = path + ":" + std::to_string(line_no) + ": expected <seconds> <multiplier>";
+            return false;
+        }
+        if (point.multiplier < 0.0 || (!loaded.empty() && point.t_s <= loaded.back().t_s))
+        {
+            error = path + ":" + std::to_string(line_no) + ": times must increase and multipliers be >= 0";
+            return false;
+        }
+        loaded.push_back(point);
+    }
+
+    if (loaded.empty())
+    {
+        error = "arrival curve " + path + " has no points";
+        return false;
+    }
+    points = std::move(loaded);
+    return true;
+}
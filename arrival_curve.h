@@ -0,0 +1,61 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Time-varying multiplier on the generator's wave rate, as a function of
+// simulated seconds since the start. The multiplier is the product of an
+// optional daily sinusoid, a piecewise-linear schedule and a sum of decaying
+// spikes. The generator samples it by thinning (see Simulation::thin_arrivals),
+// which needs bound() >= multiplier(t) for every t.
+struct ArrivalCurve
+{
+    // 1 + amplitude * cos(2 pi (t - peak_s) / period_s)
+    struct Diurnal
+    {
+        double amplitude = 0.0; // in [0, 1); 0 = flat
+        double period_s = 86400.0;
+        double peak_s = 0.0;    // time of day the rate peaks
+    };
+
+    // Patch-day spike: jumps to `factor` at at_s, decays back towards 1
+    struct Spike
+    {
+        double at_s = 0.0;
+        double factor = 1.0;    // < 1 is a dip
+        double decay_s = 600.0; // e-folding time
+    };
+
+    struct Point
+    {
+        double t_s = 0.0;
+        double multiplier = 1.0;
+    };
+
+    Diurnal diurnal;
+    std::vector<Spike> spikes;
+    std::vector<Point> points; // sorted by time; held flat outside the first/last point
+
+    // False when the generator should keep its fixed per-tick probability
+    [[nodiscard]] auto active() const -> bool
+    {
+        return diurnal.amplitude > 0.0 || !spikes.empty() || !points.empty();
+    }
+
+    [[nodiscard]] auto multiplier(double t_s) const -> double;
+
+    // Upper bound on multiplier() over all time
+    [[nodiscard]] auto bound() const -> double;
+};
+
+// "AMPLITUDE[,PERIOD_S[,PEAK_S]]"
+auto parse_diurnal(std::string_view text, ArrivalCurve::Diurnal &out) -> bool;
+
+// "AT_S,FACTOR[,DECAY_S]"
+auto parse_spike(std::string_view text, ArrivalCurve::Spike &out) -> bool;
+
+// Piecewise-linear schedule: one "seconds multiplier" pair per line, `#`
+// starts a comment, times strictly increasing. On failure returns false and
+// describes the problem in `error`.
+auto load_arrival_points(const std::string &path, std::vector<ArrivalCurve::Point> &points, std::string &error)
+    -> bool;
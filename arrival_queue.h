@@ -0,0 +1,48 @@
+#pragma once
+#include <algorithm>
+#include <deque>
+#include "policies.h"
+
+// FIFO of players of one role, stored as arrival batches so a wave of k
+// players costs one entry. Used to measure how long each player waited.
+class ArrivalQueue
+{
+public:
+    void push(SimTime arrival_ms, int count)
+    {
+        if (count <= 0)
+            return;
+        if (!batches_.empty() && batches_.back().arrival_ms == arrival_ms)
+            batches_.back().count += count;
+        else
+            batches_.push_back(Batch{arrival_ms, count});
+    }
+
+    // Remove the `count` longest-waiting players, calling on_wait(wait_ms) for each
+    template <typename OnWait>
+    void pop(int count, SimTime now_ms, OnWait &&on_wait)
+    {
+        while (count > 0 && !batches_.empty())
+        {
+            Batch &front = batches_.front();
+            int taken = std::min(count, front.count);
+            for (int i = 0; i < taken; ++i)
+            {
+                on_wait(now_ms - front.arrival_ms);
+            }
+            front.count -= taken;
+            count -= taken;
+            if (front.count == 0)
+                batches_.pop_front();
+        }
+    }
+
+private:
+    struct Batch
+    {
+        SimTime arrival_ms;
+        int count;
+    };
+
+    std::deque<Batch> batches_;
+};
@@ -0,0 +1,821 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "format.h"
+#include "parker.h"
+#include "philox.h"
+#include "player_store.h"
+#include "quantile_sketch.h"
+#include "queue_lock.h"
+#include "simulation.h"
+
+// Micro-benchmarks for the hot paths of the simulator.
+//
+//   pset2_bench filter [players]              scalar vs AVX2 attribute-window filtering
+//   pset2_bench drivers [instances] [seconds] shared-lock vs central-matcher vs pipeline
+//   pset2_bench rng [draws]                   mt19937 vs counter-based Philox durations
+//   pset2_bench sleep [samples]               plain vs deadline-spinning sleeps for compressed time
+//   pset2_bench players [count]               closed-loop queue/think/return cycle on packed records
+//   pset2_bench wake [waiters] [bursts]       party-start latency: condition variable vs spin-then-park
+//   pset2_bench locks [threads] [seconds]     std::mutex vs ticket vs MCS state lock: throughput, fairness
+//   pset2_bench generators [threads] [seconds] arrivals/s from 1 vs N generator threads, batched or not
+
+namespace
+{
+
+using BenchClock = std::chrono::steady_clock;
+
+template <typename Fn>
+auto time_ns(int iterations, Fn &&fn) -> double
+{
+    auto start = BenchClock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        fn(i);
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(BenchClock::now() - start);
+    return static_cast<double>(elapsed.count()) / iterations;
+}
+
+auto bench_filter(std::uint32_t players) -> int
+{
+    constexpr int iterations = 200;
+    std::mt19937 rng{42};
+    std::uniform_int_distribution<std::int32_t> rating(1000, 2000);
+    std::uniform_int_distribution<std::int32_t> latency(10, 200);
+
+    std::vector<std::int32_t> ratings(players);
+    std::vector<std::int32_t> latencies(players);
+    for (std::uint32_t i = 0; i < players; ++i)
+    {
+        ratings[i] = rating(rng);
+        latencies[i] = latency(rng);
+    }
+
+    // Vary the window per iteration so results cannot be hoisted
+    std::vector<AttributeWindow> windows(iterations);
+    for (int i = 0; i < iterations; ++i)
+    {
+        std::int32_t center = rating(rng);
+        windows[i] = AttributeWindow{center - 25, center + 25, 120};
+    }
+
+    std::vector<std::uint32_t> out(players);
+    std::uint64_t scalar_hits = 0;
+    std::uint64_t simd_hits = 0;
+
+    double scalar_ns = time_ns(iterations, [&](int i)
+                               { scalar_hits += filter_window_scalar(ratings.data(), latencies.data(), 0, players,
+                                                                     windows[i], out.data(), players); });
+    double simd_ns = time_ns(iterations, [&](int i)
+                             { simd_hits += filter_window_avx2(ratings.data(), latencies.data(), 0, players,
+                                                               windows[i], out.data(), players); });
+
+    FormatBuffer<512> report;
+    report.append("filter: ").append(players).append(" players, ").append(iterations).append(" windows\n")
+        .append_field<10>("scalar").append_fixed<3>(scalar_ns / players).append(" ns/player\n")
+        .append_field<10>(has_avx2() ? "avx2" : "fallback").append_fixed<3>(simd_ns / players).append(" ns/player\n")
+        .append_field<10>("speedup").append_fixed<2>(scalar_ns / simd_ns).append("x\n");
+    std::cout << report;
+
+    if (scalar_hits != simd_hits)
+    {
+        std::cerr << "Error: kernels disagree (" << scalar_hits << " vs " << simd_hits << " matches)\n";
+        return 1;
+    }
+    return 0;
+}
+
+auto bench_rng(std::uint32_t draws) -> int
+{
+    constexpr int iterations = 20;
+    constexpr int instances = 64;
+    std::vector<int> out(draws);
+
+    std::mt19937 engine{42};
+    std::uniform_int_distribution<int> dist(1, 15);
+    double mt_ns = time_ns(iterations, [&](int)
+                           {
+                               for (std::uint32_t i = 0; i < draws; ++i)
+                                   out[i] = dist(engine);
+                           });
+    std::uint64_t mt_sum = 0;
+    for (int d : out)
+        mt_sum += static_cast<std::uint64_t>(d);
+
+    // Every (instance, run) draw is independent, so each instance's batch vectorizes
+    std::uint32_t runs = draws / instances;
+    double philox_ns = time_ns(iterations, [&](int iteration)
+                               {
+                                   for (std::uint32_t inst = 0; inst < instances; ++inst)
+                                   {
+                                       philox_durations(static_cast<std::uint64_t>(iteration), inst, 0, runs,
+                                                        1, 15, out.data() + std::size_t{inst} * runs);
+                                   }
+                               });
+    std::uint64_t philox_sum = 0;
+    for (int d : out)
+        philox_sum += static_cast<std::uint64_t>(d);
+
+    FormatBuffer<512> report;
+    report.append("rng: ").append(draws).append(" durations in [1, 15]\n")
+        .append_field<10>("mt19937").append_fixed<3>(mt_ns / draws).append(" ns/draw (mean ")
+        .append_fixed<3>(static_cast<double>(mt_sum) / draws).append(")\n")
+        .append_field<10>("philox").append_fixed<3>(philox_ns / draws).append(" ns/draw (mean ")
+        .append_fixed<3>(static_cast<double>(philox_sum) / draws).append(")\n");
+    std::cout << report;
+    return 0;
+}
+
+// Every player goes once round queue -> party -> thinking -> queue per
+// round, with think times spread over ten minutes
+auto bench_players(int count) -> int
+{
+    constexpr int rounds = 5;
+    const int per_role = count / ROLE_COUNT;
+    std::mt19937 rng{42};
+    std::uniform_int_distribution<SimTime> think(0, 600'000);
+
+    auto build_start = BenchClock::now();
+    PlayerPopulation population(per_role, per_role, per_role);
+    auto build = std::chrono::duration_cast<std::chrono::nanoseconds>(BenchClock::now() - build_start);
+
+    SimTime now = 0;
+    std::uint64_t returned = 0;
+    double cycle_ns = time_ns(rounds, [&](int)
+                              {
+                                  for (int r = 0; r < ROLE_COUNT; ++r)
+                                  {
+                                      for (int i = 0; i < per_role; ++i)
+                                          population.think(population.dequeue(r), now + think(rng));
+                                  }
+                                  now += 600'000;
+                                  returned += static_cast<std::uint64_t>(population.release_due(now, [](int) {}));
+                              });
+
+    auto players = static_cast<double>(population.size());
+    FormatBuffer<512> report;
+    report.append("players: ").append(population.size()).append(" players, ").append(rounds).append(" rounds\n")
+        .append_field<10>("create").append_fixed<3>(static_cast<double>(build.count()) / players).append(" ns/player\n")
+        .append_field<10>("cycle").append_fixed<3>(cycle_ns / players).append(" ns/player\n")
+        .append_field<10>("memory").append_fixed<1>(static_cast<double>(population.memory_bytes()) / players)
+        .append(" bytes/player, ")
+        .append_fixed<1>(static_cast<double>(population.memory_bytes()) * 1e6 / players / (1024.0 * 1024.0))
+        .append(" MB per million\n");
+    std::cout << report;
+
+    if (returned != static_cast<std::uint64_t>(rounds) * population.size())
+    {
+        std::cerr << "Error: " << returned << " returns for " << rounds << " rounds\n";
+        return 1;
+    }
+    return 0;
+}
+
+// The driver benchmark compresses time so that 1 s runs take 1 ms and the
+// drivers' coordination cost is what limits throughput
+constexpr int SPEEDUP = 1000;
+
+// Far more arrivals than the instances can absorb, so instances never starve
+constexpr GeneratorConfig FLOOD{.check_interval_ms = 50,
+                                .generation_probability = 1.0,
+                                .min_tanks_per_wave = 20, .max_tanks_per_wave = 20,
+                                .min_healers_per_wave = 20, .max_healers_per_wave = 20,
+                                .min_dps_per_wave = 60, .max_dps_per_wave = 60};
+
+template <WallDriver Driver, typename StateLock = MutexLock>
+struct BenchProfile
+{
+    using Lock = StateLock;
+    using Log = SilentLog;
+    using Clock = WallClock;
+    using Rng = ThreadLocalRng;
+    static constexpr GeneratorConfig generator = FLOOD;
+    static constexpr WallDriver driver = Driver;
+};
+
+struct DriverRun
+{
+    double parties_per_s = 0.0; // wall-clock throughput
+    double handoff_us = 0.0;    // wall-clock gap between an instance's runs
+    double cpu_s = 0.0;         // process CPU time spent
+    double wall_s = 0.0;
+    std::vector<StageStats> stages;
+    std::vector<long long> served; // parties per instance
+};
+
+template <WallDriver Driver, typename StateLock = MutexLock>
+auto run_driver(int instances, int seconds) -> DriverRun
+{
+    SimulationParams params;
+    params.instances = instances;
+    params.t1 = 1;
+    params.t2 = 1;
+    params.bonus_duration = seconds * SPEEDUP;
+    params.speedup = SPEEDUP;
+
+    Simulation<BenchProfile<Driver, StateLock>> sim(params);
+    std::clock_t cpu_start = std::clock();
+    auto start = BenchClock::now();
+    sim.run();
+    auto wall = std::chrono::duration<double>(BenchClock::now() - start).count();
+    SimulationResult result = sim.result();
+
+    DriverRun run;
+    long long served = 0;
+    for (const Instance &inst : result.instances)
+    {
+        served += inst.served;
+        run.served.push_back(inst.served);
+    }
+
+    run.parties_per_s = static_cast<double>(served) / wall;
+    if (result.handoffs > 0)
+        run.handoff_us = result.idle_between_runs_ms * 1000.0 / static_cast<double>(result.handoffs) / SPEEDUP;
+    run.cpu_s = static_cast<double>(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+    run.wall_s = wall;
+    run.stages = result.stages;
+    return run;
+}
+
+// Mean and worst overshoot, in microseconds, of sleeping `target` `samples` times
+template <typename Sleep>
+auto overshoot_us(std::chrono::nanoseconds target, int samples, Sleep &&sleep) -> std::pair<double, double>
+{
+    double total = 0.0;
+    double worst = 0.0;
+    for (int i = 0; i < samples; ++i)
+    {
+        auto start = BenchClock::now();
+        sleep(start, target);
+        double over = std::chrono::duration<double, std::micro>(BenchClock::now() - start - target).count();
+        total += over;
+        worst = std::max(worst, over);
+    }
+    return {total / samples, worst};
+}
+
+auto bench_sleep(int samples) -> int
+{
+    FormatBuffer<1024> report;
+    report.append("sleep: ").append(samples).append(" sleeps per length; overshoot mean / max in us\n")
+        .append_field<10>("length").append_field<22>("sleep_for").append("deadline + spin\n");
+    for (auto target : {std::chrono::microseconds(20), std::chrono::microseconds(100), std::chrono::microseconds(500),
+                        std::chrono::microseconds(2000)})
+    {
+        auto plain = overshoot_us(target, samples, [](BenchClock::time_point, std::chrono::nanoseconds length)
+                                  { std::this_thread::sleep_for(length); });
+        auto precise = overshoot_us(target, samples, [](BenchClock::time_point start, std::chrono::nanoseconds length)
+                                    { precise_sleep_until(start + length); });
+        FormatBuffer<32> length;
+        length.append(std::chrono::duration_cast<std::chrono::microseconds>(target).count()).append(" us");
+        FormatBuffer<32> plain_text;
+        plain_text.append_fixed<1>(plain.first).append(" / ").append_fixed<1>(plain.second);
+        report.append_field<10>(length.view()).append_field<22>(plain_text.view())
+            .append_fixed<1>(precise.first).append(" / ").append_fixed<1>(precise.second).append('\n');
+    }
+    std::cout << report;
+    return 0;
+}
+
+// Idle waiters take parties from a mutex-guarded count, as instance threads
+// do in the shared-lock driver. The producer posts bursts of 1..waiters/2
+// parties at random 100-1000 us gaps, each after the last burst was taken;
+// a party's latency is from its burst being posted to a waiter taking it.
+// Each waiter then spends a short run away before it waits again.
+struct WakeRun
+{
+    QuantileSketch latency_us;
+    long long futile = 0; // wake-ups that found no party
+    double cpu_s = 0.0;   // process CPU time, all threads
+};
+
+struct PartyBoard
+{
+    std::mutex mutex;
+    int parties = 0;
+    bool stop = false;
+    BenchClock::time_point posted;
+    WakeRun run;
+
+    // Caller holds mutex
+    void take()
+    {
+        parties -= 1;
+        run.latency_us.add(std::chrono::duration<double, std::micro>(BenchClock::now() - posted).count());
+    }
+
+    // A short dungeon run, away from the board
+    static void run_party(std::unique_lock<std::mutex> &lock)
+    {
+        lock.unlock();
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+        lock.lock();
+    }
+};
+
+// Post the bursts, then stop; `post(n)` adds n parties and wakes waiters
+template <typename Post, typename Stop>
+void post_bursts(PartyBoard &board, int waiters, int bursts, Post &&post, Stop &&stop)
+{
+    std::mt19937 rng{42};
+    std::uniform_int_distribution<int> size(1, std::max(waiters / 2, 1));
+    std::uniform_int_distribution<int> gap_us(100, 1000);
+    for (int b = 0; b < bursts; ++b)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(gap_us(rng)));
+        post(size(rng));
+        while (true)
+        {
+            {
+                std::scoped_lock lock(board.mutex);
+                if (board.parties == 0)
+                    break;
+            }
+            // Poll gently: a busy producer would starve the waiters on few cores
+            std::this_thread::sleep_for(std::chrono::microseconds(20));
+        }
+    }
+    stop();
+}
+
+// Every waiter shares one condition variable and every burst wakes them all
+auto wake_condvar(int waiters, int bursts) -> WakeRun
+{
+    PartyBoard board;
+    std::clock_t cpu_start = std::clock();
+    std::condition_variable cv;
+    auto waiter = [&]()
+    {
+        std::unique_lock lock(board.mutex);
+        while (true)
+        {
+            while (board.parties == 0 && !board.stop)
+            {
+                cv.wait(lock);
+                if (board.parties == 0 && !board.stop)
+                    board.run.futile += 1;
+            }
+            if (board.stop)
+                return;
+            board.take();
+            board.run_party(lock);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int i = 0; i < waiters; ++i)
+        pool.emplace_back(waiter);
+    post_bursts(board, waiters, bursts,
+                [&](int n)
+                {
+                    {
+                        std::scoped_lock lock(board.mutex);
+                        board.parties += n;
+                        board.posted = BenchClock::now();
+                    }
+                    cv.notify_all();
+                },
+                [&]()
+                {
+                    {
+                        std::scoped_lock lock(board.mutex);
+                        board.stop = true;
+                    }
+                    cv.notify_all();
+                });
+    for (auto &th : pool)
+        th.join();
+    board.run.cpu_s = static_cast<double>(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+    return std::move(board.run);
+}
+
+// Waiters queue up in an idle list and each parks on its own Parker; a burst
+// of n parties unparks the n oldest
+auto wake_parker(int waiters, int bursts, int spins) -> WakeRun
+{
+    PartyBoard board;
+    std::clock_t cpu_start = std::clock();
+    std::vector<Parker> parkers(waiters);
+    std::vector<int> idle;
+    auto waiter = [&](int id)
+    {
+        std::unique_lock lock(board.mutex);
+        while (true)
+        {
+            while (board.parties == 0 && !board.stop)
+            {
+                idle.push_back(id);
+                lock.unlock();
+                parkers[id].park(spins);
+                lock.lock();
+                if (board.parties == 0 && !board.stop)
+                    board.run.futile += 1;
+            }
+            if (board.stop)
+                return;
+            board.take();
+            board.run_party(lock);
+        }
+    };
+    // Caller holds board.mutex
+    auto claim = [&](std::size_t count)
+    {
+        count = std::min(count, idle.size());
+        std::vector<int> woken(idle.begin(), idle.begin() + static_cast<std::ptrdiff_t>(count));
+        idle.erase(idle.begin(), idle.begin() + static_cast<std::ptrdiff_t>(count));
+        return woken;
+    };
+
+    std::vector<std::thread> pool;
+    for (int i = 0; i < waiters; ++i)
+        pool.emplace_back(waiter, i);
+    post_bursts(board, waiters, bursts,
+                [&](int n)
+                {
+                    std::vector<int> woken;
+                    {
+                        std::scoped_lock lock(board.mutex);
+                        board.parties += n;
+                        board.posted = BenchClock::now();
+                        woken = claim(static_cast<std::size_t>(board.parties));
+                    }
+                    for (int id : woken)
+                        parkers[id].unpark();
+                },
+                [&]()
+                {
+                    std::vector<int> woken;
+                    {
+                        std::scoped_lock lock(board.mutex);
+                        board.stop = true;
+                        woken = claim(idle.size());
+                    }
+                    for (int id : woken)
+                        parkers[id].unpark();
+                });
+    for (auto &th : pool)
+        th.join();
+    board.run.cpu_s = static_cast<double>(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+    return std::move(board.run);
+}
+
+auto bench_wake(int waiters, int bursts) -> int
+{
+    const int spins = 2048;
+    WakeRun condvar = wake_condvar(waiters, bursts);
+    WakeRun park = wake_parker(waiters, bursts, 0);
+    WakeRun spin_park = wake_parker(waiters, bursts, spins);
+
+    FormatBuffer<1024> report;
+    report.append("wake: ").append(waiters).append(" idle waiters, ").append(bursts)
+        .append(" bursts; party-start latency in us\n")
+        .append_field<16>("").append_field<10>("mean").append_field<10>("p50").append_field<10>("p99")
+        .append_field<10>("cpu s").append("futile wake-ups\n");
+    auto row = [&report](std::string_view name, const WakeRun &run)
+    {
+        report.append_field<16>(name);
+        for (double us : {run.latency_us.mean(), run.latency_us.quantile(0.50), run.latency_us.quantile(0.99)})
+        {
+            FormatBuffer<32> cell;
+            cell.append_fixed<1>(us);
+            report.append_field<10>(cell.view());
+        }
+        FormatBuffer<32> cpu;
+        cpu.append_fixed<2>(run.cpu_s);
+        report.append_field<10>(cpu.view());
+        report.append(run.futile).append('\n');
+    };
+    row("condvar", condvar);
+    row("futex park", park);
+    row("spin + park", spin_park);
+    report.append(std::thread::hardware_concurrency()).append(" hardware threads; spin + park spins ")
+        .append(spins).append(" rounds (the engine skips spinning on a single core)\n");
+    std::cout << report;
+    return 0;
+}
+
+void append_driver(FormatBuffer<1024> &report, std::string_view name, const DriverRun &run)
+{
+    report.append_field<16>(name)
+        .append_fixed<0>(run.parties_per_s).append(" parties/s, handoff ")
+        .append_fixed<1>(run.handoff_us).append(" us, cpu ")
+        .append_fixed<2>(run.cpu_s).append(" s\n");
+    for (const StageStats &stage : run.stages)
+    {
+        report.append("  ").append_field<14>(stage.name)
+            .append_fixed<0>(static_cast<double>(stage.events) / run.wall_s).append(" events/s, wait ")
+            .append_fixed<1>(stage.latency_us / SPEEDUP).append(" us\n");
+    }
+}
+
+auto bench_drivers(int instances, int seconds) -> int
+{
+    DriverRun shared = run_driver<WallDriver::SharedLock>(instances, seconds);
+    DriverRun central = run_driver<WallDriver::CentralMatcher>(instances, seconds);
+    DriverRun pipeline = run_driver<WallDriver::Pipeline>(instances, seconds);
+
+    FormatBuffer<1024> report;
+    report.append("drivers: ").append(instances).append(" instances, 1 ms runs, ")
+        .append(seconds).append(" s per driver\n");
+    append_driver(report, "shared lock", shared);
+    append_driver(report, "central matcher", central);
+    append_driver(report, "pipeline", pipeline);
+    std::cout << report;
+    return 0;
+}
+
+// Jain's fairness index of per-thread (or per-instance) shares: 1 when all
+// are equal, 1/n when one takes everything
+auto jain_index(const std::vector<long long> &shares) -> double
+{
+    double sum = 0.0;
+    double squares = 0.0;
+    for (long long share : shares)
+    {
+        auto x = static_cast<double>(share);
+        sum += x;
+        squares += x * x;
+    }
+    return squares > 0.0 ? sum * sum / (static_cast<double>(shares.size()) * squares) : 1.0;
+}
+
+struct LockRun
+{
+    double per_s = 0.0;            // acquisitions per second, all threads
+    std::vector<long long> shares; // acquisitions per thread
+    long long longest_streak = 0;  // most consecutive acquisitions by one thread
+    QuantileSketch wait_us;        // time to acquire, every 16th acquisition
+};
+
+// Every thread loops on a short critical section, like an instance thread
+// checking the role counts, with a little work outside the lock
+template <typename Mutex>
+auto contend(int threads, double seconds) -> LockRun
+{
+    Mutex mutex;
+    std::atomic<bool> stop{false};
+    std::atomic<std::uint64_t> sink{0}; // keeps the outside work from being optimized away
+    long long shared_work = 0;
+    int last_owner = -1;
+    long long streak = 0;
+    LockRun run;
+    run.shares.assign(static_cast<std::size_t>(threads), 0);
+
+    std::vector<std::thread> pool;
+    auto start = BenchClock::now();
+    for (int t = 0; t < threads; ++t)
+    {
+        pool.emplace_back([&, t]
+                          {
+                              long long mine = 0;
+                              std::uint64_t local = static_cast<std::uint64_t>(t) + 1;
+                              QuantileSketch waits;
+                              while (!stop.load(std::memory_order_relaxed))
+                              {
+                                  bool timed = mine % 16 == 0;
+                                  auto asked = timed ? BenchClock::now() : BenchClock::time_point{};
+                                  {
+                                      std::scoped_lock lock(mutex);
+                                      if (timed)
+                                          waits.add(std::chrono::duration<double, std::micro>(BenchClock::now() - asked).count());
+                                      for (int i = 0; i < 16; ++i)
+                                          shared_work += i;
+                                      streak = last_owner == t ? streak + 1 : 1;
+                                      last_owner = t;
+                                      run.longest_streak = std::max(run.longest_streak, streak);
+                                  }
+                                  ++mine;
+                                  for (int i = 0; i < 64; ++i)
+                                      local = local * 6364136223846793005ULL + 1442695040888963407ULL;
+                              }
+                              sink.fetch_xor(local, std::memory_order_relaxed);
+                              std::scoped_lock lock(mutex);
+                              run.shares[static_cast<std::size_t>(t)] = mine;
+                              run.wait_us.merge(waits);
+                          });
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop.store(true, std::memory_order_relaxed);
+    for (auto &thread : pool)
+        thread.join();
+    auto wall = std::chrono::duration<double>(BenchClock::now() - start).count();
+
+    long long total = 0;
+    for (long long share : run.shares)
+        total += share;
+    run.per_s = static_cast<double>(total) / wall;
+    return run;
+}
+
+void append_shares(FormatBuffer<2048> &report, const std::vector<long long> &shares)
+{
+    auto [lo, hi] = std::minmax_element(shares.begin(), shares.end());
+    double mean = 0.0;
+    for (long long share : shares)
+        mean += static_cast<double>(share);
+    mean /= static_cast<double>(shares.size());
+    FormatBuffer<32> min_cell;
+    min_cell.append_fixed<2>(mean > 0.0 ? static_cast<double>(*lo) / mean : 0.0);
+    FormatBuffer<32> max_cell;
+    max_cell.append_fixed<2>(mean > 0.0 ? static_cast<double>(*hi) / mean : 0.0);
+    FormatBuffer<32> jain_cell;
+    jain_cell.append_fixed<4>(jain_index(shares));
+    report.append_field<10>(min_cell.view()).append_field<10>(max_cell.view()).append_field<10>(jain_cell.view());
+}
+
+auto bench_locks(int threads, int seconds) -> int
+{
+    const int instances = 64;
+    LockRun raw_mutex = contend<std::mutex>(threads, seconds);
+    LockRun raw_ticket = contend<TicketMutex>(threads, seconds);
+    LockRun raw_mcs = contend<McsMutex>(threads, seconds);
+    DriverRun sim_mutex = run_driver<WallDriver::SharedLock, MutexLock>(instances, seconds);
+    DriverRun sim_ticket = run_driver<WallDriver::SharedLock, TicketLock>(instances, seconds);
+    DriverRun sim_mcs = run_driver<WallDriver::SharedLock, McsLock>(instances, seconds);
+
+    FormatBuffer<2048> report;
+    report.append("locks: ").append(threads).append(" threads on one lock, ").append(seconds)
+        .append(" s each; shares are per thread relative to the mean\n")
+        .append_field<10>("").append_field<14>("acq/s").append_field<10>("min").append_field<10>("max")
+        .append_field<10>("Jain").append_field<16>("longest streak").append_field<12>("p99 wait")
+        .append("max wait (us)\n");
+    auto raw_row = [&report](std::string_view name, const LockRun &run)
+    {
+        report.append_field<10>(name).append_field<14>(static_cast<long long>(run.per_s));
+        append_shares(report, run.shares);
+        report.append_field<16>(run.longest_streak);
+        FormatBuffer<32> p99;
+        p99.append_fixed<1>(run.wait_us.quantile(0.99));
+        report.append_field<12>(p99.view()).append_fixed<0>(run.wait_us.max()).append('\n');
+    };
+    raw_row("mutex", raw_mutex);
+    raw_row("ticket", raw_ticket);
+    raw_row("mcs", raw_mcs);
+
+    report.append("\nshared-lock driver: ").append(instances).append(" instances, 1 ms runs; shares are parties per instance\n")
+        .append_field<10>("").append_field<14>("parties/s").append_field<10>("min").append_field<10>("max")
+        .append_field<10>("Jain").append("cpu s\n");
+    auto sim_row = [&report](std::string_view name, const DriverRun &run)
+    {
+        report.append_field<10>(name).append_field<14>(static_cast<long long>(run.parties_per_s));
+        append_shares(report, run.served);
+        report.append_fixed<2>(run.cpu_s).append('\n');
+    };
+    sim_row("mutex", sim_mutex);
+    sim_row("ticket", sim_ticket);
+    sim_row("mcs", sim_mcs);
+    report.append(std::thread::hardware_concurrency()).append(" hardware threads\n");
+    std::cout << report;
+    return 0;
+}
+
+// Every tick of every generator thread rolls 10 players, and a tick is
+// 1 us of real time, so the generator loop itself is the limit. No party
+// can ever form, so instances stay idle and the run ends on time instead of
+// draining millions of queued players.
+constexpr GeneratorConfig STRESS{.check_interval_ms = 1,
+                                 .generation_probability = 1.0,
+                                 .min_tanks_per_wave = 2, .max_tanks_per_wave = 2,
+                                 .min_healers_per_wave = 2, .max_healers_per_wave = 2,
+                                 .min_dps_per_wave = 6, .max_dps_per_wave = 6};
+
+struct GeneratorRun
+{
+    double arrivals_per_s = 0.0;
+    double cpu_s = 0.0;
+};
+
+template <WallDriver Driver>
+auto run_generators(int threads, int batch, int seconds) -> GeneratorRun
+{
+    SimulationParams params;
+    params.instances = 1;
+    params.party.dps = std::numeric_limits<int>::max();
+    params.bonus_duration = seconds * SPEEDUP;
+    params.speedup = SPEEDUP;
+    params.generator = STRESS;
+    params.generator_threads = threads;
+    params.generator_batch = batch;
+
+    Simulation<BenchProfile<Driver>> sim(params);
+    std::clock_t cpu_start = std::clock();
+    auto start = BenchClock::now();
+    sim.run();
+    auto wall = std::chrono::duration<double>(BenchClock::now() - start).count();
+    SimulationResult result = sim.result();
+
+    GeneratorRun run;
+    auto arrivals = static_cast<double>(result.bonus_tanks_added) + result.bonus_healers_added + result.bonus_dps_added;
+    run.arrivals_per_s = arrivals / wall;
+    run.cpu_s = static_cast<double>(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+    return run;
+}
+
+auto bench_generators(int threads, int seconds) -> int
+{
+    constexpr int BATCH = 1024;
+    FormatBuffer<1024> report;
+    report.append("generators: 10-player waves every 1 us tick per thread, ").append(seconds)
+        .append(" s per run; batches of ").append(BATCH).append(" players\n")
+        .append_field<24>("").append_field<16>("shared lock").append_field<16>("cpu s")
+        .append_field<16>("central matcher").append("cpu s\n");
+    auto row = [&report, seconds](int count, int batch)
+    {
+        GeneratorRun shared = run_generators<WallDriver::SharedLock>(count, batch, seconds);
+        GeneratorRun central = run_generators<WallDriver::CentralMatcher>(count, batch, seconds);
+        FormatBuffer<32> label;
+        label.append(count).append(count == 1 ? " thread, " : " threads, ").append(batch > 0 ? "batched" : "per wave");
+        report.append_field<24>(label.view());
+        FormatBuffer<32> shared_rate;
+        shared_rate.append_fixed<0>(shared.arrivals_per_s);
+        FormatBuffer<32> shared_cpu;
+        shared_cpu.append_fixed<2>(shared.cpu_s);
+        FormatBuffer<32> central_rate;
+        central_rate.append_fixed<0>(central.arrivals_per_s);
+        report.append_field<16>(shared_rate.view()).append_field<16>(shared_cpu.view())
+            .append_field<16>(central_rate.view()).append_fixed<2>(central.cpu_s).append('\n');
+    };
+    row(1, 0);
+    row(1, BATCH);
+    row(threads, 0);
+    row(threads, BATCH);
+    report.append("arrivals per second of wall time; ").append(std::thread::hardware_concurrency())
+        .append(" hardware threads\n");
+    std::cout << report;
+    return 0;
+}
+
+} // namespace
+
+auto main(int argc, char *argv[]) -> int
+{
+    std::string_view which = argc > 1 ? argv[1] : "";
+    if (which == "filter")
+    {
+        std::uint32_t players = argc > 2 ? static_cast<std::uint32_t>(std::stoul(argv[2])) : 1U << 20;
+        return bench_filter(players);
+    }
+    if (which == "rng")
+    {
+        std::uint32_t draws = argc > 2 ? static_cast<std::uint32_t>(std::stoul(argv[2])) : 1U << 20;
+        return bench_rng(draws);
+    }
+    if (which == "drivers")
+    {
+        int instances = argc > 2 ? std::stoi(argv[2]) : 64;
+        int seconds = argc > 3 ? std::stoi(argv[3]) : 2;
+        return bench_drivers(instances, seconds);
+    }
+
+    if (which == "sleep")
+    {
+        int samples = argc > 2 ? std::stoi(argv[2]) : 2000;
+        return bench_sleep(samples);
+    }
+
+    if (which == "wake")
+    {
+        int waiters = argc > 2 ? std::stoi(argv[2]) : 32;
+        int bursts = argc > 3 ? std::stoi(argv[3]) : 2000;
+        return bench_wake(waiters, bursts);
+    }
+    if (which == "locks")
+    {
+        int threads = argc > 2 ? std::stoi(argv[2]) : 8;
+        int seconds = argc > 3 ? std::stoi(argv[3]) : 2;
+        return bench_locks(threads, seconds);
+    }
+    if (which == "generators")
+    {
+        int threads = argc > 2 ? std::stoi(argv[2]) : 4;
+        int seconds = argc > 3 ? std::stoi(argv[3]) : 1;
+        return bench_generators(threads, seconds);
+    }
+    if (which == "players")
+    {
+        int count = argc > 2 ? std::stoi(argv[2]) : 3'000'000;
+        return bench_players(count);
+    }
+
+    std::cerr << "Usage: " << argv[0] << " <benchmark> [args]\n"
+              << "  filter [players]   scalar vs AVX2 attribute-window filtering (default 1048576)\n"
+              << "  drivers [instances] [seconds]   shared-lock vs central-matcher vs pipeline (default 64 2)\n"
+              << "  rng [draws]        mt19937 vs counter-based Philox durations (default 1048576)\n"
+              << "  sleep [samples]    plain vs deadline-spinning sleeps for compressed time (default 2000)\n"
+              << "  wake [waiters] [bursts]   condition variable vs spin-then-park wake-ups (default 32 2000)\n"
+              << "  locks [threads] [seconds]   std::mutex vs ticket vs MCS state lock (default 8 2)\n"
+              << "  generators [threads] [seconds]   arrivals/s from 1 vs N generator threads (default 4 1)\n"
+              << "  players [count]    closed-loop queue/think/return cycle on packed records (default 3000000)\n";
+    return 1;
+}
@@ -0,0 +1,269 @@
+#include "config.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string_view>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "policies.h"
+#include "utils.h"
+
+namespace
+{
+
+// Integer setting named by `key`, or nullptr if the key is not one
+auto int_field(std::string_view key, SimulationParams &params, GeneratorConfig &gen) -> int *
+{
+    if (key == "instances") return &params.instances;
+    if (key == "tanks") return &params.tanks;
+    if (key == "healers") return &params.healers;
+    if (key == "dps") return &params.dps;
+    if (key == "t1") return &params.t1;
+    if (key == "t2") return &params.t2;
+    if (key == "bonus_duration") return &params.bonus_duration;
+    if (key == "lookahead_ms") return &params.lookahead_ms;
+    if (key == "bonus_lead_ms") return &params.bonus_lead_ms;
+    if (key == "think_ms") return &params.think_ms;
+    if (key == "idle_spins") return &params.idle_spins;
+    if (key == "generator_threads") return &params.generator_threads;
+    if (key == "generator_batch") return &params.generator_batch;
+    if (key == "party.tanks") return &params.party.tanks;
+    if (key == "party.healers") return &params.party.healers;
+    if (key == "party.dps") return &params.party.dps;
+    if (key == "match.rating_window") return &params.rating_window;
+    if (key == "match.max_latency_ms") return &params.max_latency_ms;
+    if (key == "match.regions") return &params.regions;
+    if (key == "match.region_penalty_ms") return &params.region_penalty_ms;
+    if (key == "match.relax_ms_per_s") return &params.latency_relax_ms_per_s;
+    if (key == "generator.interval_ms") return &gen.check_interval_ms;
+    if (key == "generator.min_tanks") return &gen.min_tanks_per_wave;
+    if (key == "generator.max_tanks") return &gen.max_tanks_per_wave;
+    if (key == "generator.min_healers") return &gen.min_healers_per_wave;
+    if (key == "generator.max_healers") return &gen.max_healers_per_wave;
+    if (key == "generator.min_dps") return &gen.min_dps_per_wave;
+    if (key == "generator.max_dps") return &gen.max_dps_per_wave;
+    return nullptr;
+}
+
+auto validate(const SimulationParams &params, const GeneratorConfig &gen, std::string &error) -> bool
+{
+    const PartyTemplate &party = params.party;
+    if (party.tanks < 0 || party.healers < 0 || party.dps < 0 ||
+        party.tanks + party.healers + party.dps < 1)
+    {
+        error = "party template needs non-negative role counts and at least one player";
+        return false;
+    }
+    if (gen.check_interval_ms < 1)
+    {
+        error = "generator.interval_ms must be >= 1";
+        return false;
+    }
+    if (gen.generation_probability < 0.0 || gen.generation_probability > 1.0)
+    {
+        error = "generator.probability must be in [0, 1]";
+        return false;
+    }
+    if (gen.min_tanks_per_wave < 0 || gen.min_tanks_per_wave > gen.max_tanks_per_wave ||
+        gen.min_healers_per_wave < 0 || gen.min_healers_per_wave > gen.max_healers_per_wave ||
+        gen.min_dps_per_wave < 0 || gen.min_dps_per_wave > gen.max_dps_per_wave)
+    {
+        error = "generator wave sizes need 0 <= min <= max";
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+auto load_config(const std::string &path, SimulationParams &params, std::string &error) -> bool
+{
+    std::ifstream in(path);
+    if (!in)
+    {
+        error = "cannot open config file " + path;
+        return false;
+    }
+
+    SimulationParams updated = params;
+    GeneratorConfig gen = updated.generator.value_or(GeneratorConfig{});
+    bool generator_touched = false;
+
+    std::string raw;
+    int line_no = 0;
+    while (std::getline(in, raw))
+    {
+        ++line_no;
+        std::string_view line = raw;
+        if (auto hash = line.find('#'); hash != std::string_view::npos)
+            line = line.substr(0, hash);
+        line = trim(line);
+        if (line.empty())
+            continue;
+
+        auto eq = line.find('=');
+        if (eq == std::string_view::npos)
+        {
+            error = path + ":" + std::to_string(line_no) + ": expected key = value";
+            return false;
+        }
+        std::string_view key = trim(line.substr(0, eq));
+        std::string_view value = trim(line.substr(eq + 1));
+
+        bool ok = false;
+        if (key == "seed")
+        {
+            ok = parse_number(value, updated.seed);
+            updated.seed_given = true;
+        }
+        else if (key == "closed_loop")
+        {
+            int flag = 0;
+            ok = parse_number(value, flag) && (flag == 0 || flag == 1);
+            updated.closed_loop = flag == 1;
+        }
+        else if (key == "speedup")
+            ok = parse_number(value, updated.speedup);
+        else if (key == "generator.probability")
+            ok = parse_number(value, gen.generation_probability);
+        else if (int *field = int_field(key, updated, gen))
+            ok = parse_number(value, *field);
+        else
+        {
+            error = path + ":" + std::to_string(line_no) + ": unknown key '" + std::string(key) + "'";
+            return false;
+        }
+
+        if (!ok)
+        {
+            error = path + ":" + std::to_string(line_no) + ": invalid value for '" + std::string(key) + "'";
+            return false;
+        }
+        generator_touched = generator_touched || key.starts_with("generator.");
+    }
+
+    if (!validate(updated, gen, error))
+    {
+        error = path + ": " + error;
+        return false;
+    }
+
+    if (generator_touched)
+        updated.generator = gen;
+    params = updated;
+    return true;
+}
+
+ConfigWatcher::ConfigWatcher(std::string path, SimulationParams base, Callback on_change)
+    : path_(std::move(path)), base_(std::move(base)), on_change_(std::move(on_change))
+{
+}
+
+ConfigWatcher::~ConfigWatcher()
+{
+    stop();
+}
+
+#ifdef __linux__
+
+auto ConfigWatcher::start(std::string &error) -> bool
+{
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ < 0)
+    {
+        error = "inotify_init1 failed";
+        return false;
+    }
+
+    // Watch the directory, not the file: editors often save by renaming a new file over the old one
+    std::filesystem::path file(path_);
+    std::filesystem::path dir = file.has_parent_path() ? file.parent_path() : ".";
+    if (inotify_add_watch(inotify_fd_, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    {
+        error = "cannot watch " + dir.string();
+        close(inotify_fd_);
+        inotify_fd_ = -1;
+        return false;
+    }
+
+    worker_ = std::thread(&ConfigWatcher::watch_loop, this);
+    return true;
+}
+
+void ConfigWatcher::stop()
+{
+    stopping_ = true;
+    if (worker_.joinable())
+        worker_.join();
+    if (inotify_fd_ >= 0)
+    {
+        close(inotify_fd_);
+        inotify_fd_ = -1;
+    }
+}
+
+void ConfigWatcher::watch_loop()
+{
+    constexpr int poll_timeout_ms = 200; // bounds how long stop() waits
+    const std::string file_name = std::filesystem::path(path_).filename().string();
+    alignas(inotify_event) char buffer[4096];
+
+    while (!stopping_)
+    {
+        pollfd pfd{inotify_fd_, POLLIN, 0};
+        if (poll(&pfd, 1, poll_timeout_ms) <= 0)
+            continue;
+
+        ssize_t len = read(inotify_fd_, buffer, sizeof(buffer));
+        bool changed = false;
+        for (ssize_t offset = 0; offset < len;)
+        {
+            const auto *event = reinterpret_cast<const inotify_event *>(buffer + offset);
+            if (event->len > 0 && file_name == event->name)
+                changed = true;
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+        }
+
+        if (changed)
+            reload();
+    }
+}
+
+#else
+
+auto ConfigWatcher::start(std::string &error) -> bool
+{
+    error = "config hot reload needs inotify (Linux only)";
+    return false;
+}
+
+void ConfigWatcher::stop() {}
+
+void ConfigWatcher::watch_loop() {}
+
+#endif
+
+void ConfigWatcher::reload()
+{
+    SimulationParams params = base_;
+    std::string error;
+    ConsoleLog log;
+    if (!load_config(path_, params, error))
+    {
+        log.write("[Config] Reload failed, keeping previous settings: ", error, "\n");
+        return;
+    }
+
+    GeneratorConfig gen = params.generator.value_or(GeneratorConfig{});
+    on_change_(gen);
+    log.write("[Config] Reloaded generator: interval ", gen.check_interval_ms,
+              "ms, probability ", gen.generation_probability,
+              ", wave tanks [", gen.min_tanks_per_wave, ',', gen.max_tanks_per_wave,
+              "] healers [", gen.min_healers_per_wave, ',', gen.max_healers_per_wave,
+              "] dps [", gen.min_dps_per_wave, ',', gen.max_dps_per_wave, "]\n");
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+#include "simulation.h"
+
+// Config file format: one `key = value` per line, `#` starts a comment.
+//
+//   instances = 10            tanks / healers / dps = initial players
+//   t1 = 1                    t2 = 15
+//   bonus_duration = 0        seed = 42                lookahead_ms = 0
+//   bonus_lead_ms = 0         (start bonus generation this long before the initial players run out)
+//   closed_loop = 0           think_ms = 5000          speedup = 1
+//   idle_spins = -1           (-1 = 2048, or 0 on a single core)
+//   generator_threads = 1     generator_batch = 0      (0 = hand over every wave)
+//   party.tanks = 1           party.healers = 1        party.dps = 3
+//   generator.interval_ms = 500
+//   generator.probability = 0.3
+//   generator.min_tanks = 0   generator.max_tanks = 2  (same for healers, dps)
+//   match.rating_window = 0   match.max_latency_ms = 0
+//   match.regions = 1         match.region_penalty_ms = 80   match.relax_ms_per_s = 0
+//
+// Only generator.* keys are hot-reloadable; the rest are read once at start-up.
+
+// Apply every key in `path` on top of `params`. On failure returns false,
+// leaves `params` untouched and describes the problem in `error`.
+auto load_config(const std::string &path, SimulationParams &params, std::string &error) -> bool;
+
+// Watches a config file with inotify and reports the generator settings each
+// time the file is rewritten. Callbacks run on the watcher's own thread.
+class ConfigWatcher
+{
+public:
+    using Callback = std::function<void(const GeneratorConfig &)>;
+
+    ConfigWatcher(std::string path, SimulationParams base, Callback on_change);
+    ~ConfigWatcher();
+
+    ConfigWatcher(const ConfigWatcher &) = delete;
+    auto operator=(const ConfigWatcher &) -> ConfigWatcher & = delete;
+
+    // Start watching; returns false (with `error` set) if inotify is unavailable
+    auto start(std::string &error) -> bool;
+    void stop();
+
+private:
+    void watch_loop();
+    void reload();
+
+    std::string path_;
+    SimulationParams base_; // start-up parameters; reloads are applied on top of a copy
+    Callback on_change_;
+    int inotify_fd_ = -1;
+    std::atomic<bool> stopping_ = false;
+    std::thread worker_;
+};
@@ -0,0 +1,125 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+// Building blocks for an LMAX Disruptor-style pipeline: preallocated rings
+// whose slots are addressed by ever-increasing 64-bit sequence numbers, and
+// cache-line padded sequences that stages publish their progress through.
+// A stage never writes a slot until every stage reading it has moved past
+// (gating), and never reads a slot before its producer published it (barrier).
+
+// Progress of one producer or consumer; -1 = nothing yet
+struct alignas(64) Sequence
+{
+    std::atomic<std::int64_t> value{-1};
+
+    [[nodiscard]] auto load() const -> std::int64_t { return value.load(std::memory_order_acquire); }
+    void store(std::int64_t v) { value.store(v, std::memory_order_release); }
+};
+
+// Futex-backed wake-up for a stage. Publishers ring it; the stage snapshots
+// it before looking for work and sleeps on the snapshot if there was none,
+// so a publish in between is never missed.
+class alignas(64) Doorbell
+{
+public:
+    [[nodiscard]] auto snapshot() const -> std::uint32_t { return rings_.load(std::memory_order_acquire); }
+    void wait(std::uint32_t seen) const { rings_.wait(seen, std::memory_order_acquire); }
+
+    void ring_one()
+    {
+        rings_.fetch_add(1, std::memory_order_release);
+        rings_.notify_one();
+    }
+    void ring_all()
+    {
+        rings_.fetch_add(1, std::memory_order_release);
+        rings_.notify_all();
+    }
+
+private:
+    std::atomic<std::uint32_t> rings_{0};
+};
+
+// Spin briefly, then yield, while `ready()` is false. For gating waits that
+// are expected to be short or rare.
+template <typename Ready>
+void spin_until(Ready &&ready)
+{
+    for (int spins = 0; !ready(); ++spins)
+    {
+        if (spins > 64)
+            std::this_thread::yield();
+    }
+}
+
+// Capacity rounded up to a power of two
+inline auto ring_capacity(std::size_t wanted) -> std::size_t
+{
+    std::size_t size = 2;
+    while (size < wanted)
+        size <<= 1;
+    return size;
+}
+
+// Ring with a single producer. The producer writes slot(seq) and then
+// publish(seq); consumers may read slot(s) for every s <= cursor().
+template <typename T>
+class SingleProducerRing
+{
+public:
+    explicit SingleProducerRing(std::size_t capacity)
+        : mask_(ring_capacity(capacity) - 1), slots_(std::make_unique<T[]>(mask_ + 1))
+    {
+    }
+
+    [[nodiscard]] auto capacity() const -> std::int64_t { return static_cast<std::int64_t>(mask_ + 1); }
+    [[nodiscard]] auto slot(std::int64_t seq) -> T & { return slots_[static_cast<std::size_t>(seq) & mask_]; }
+    [[nodiscard]] auto cursor() const -> std::int64_t { return cursor_.load(); }
+    void publish(std::int64_t seq) { cursor_.store(seq); }
+
+private:
+    std::size_t mask_;
+    std::unique_ptr<T[]> slots_;
+    Sequence cursor_;
+};
+
+// Ring with many producers. Each producer claims a sequence, writes the
+// slot and marks it available; the single consumer reads slots in order as
+// they become available (a slow producer holds back later sequences).
+template <typename T>
+class MultiProducerRing
+{
+public:
+    explicit MultiProducerRing(std::size_t capacity)
+        : mask_(ring_capacity(capacity) - 1),
+          slots_(std::make_unique<Slot[]>(mask_ + 1))
+    {
+    }
+
+    [[nodiscard]] auto capacity() const -> std::int64_t { return static_cast<std::int64_t>(mask_ + 1); }
+    [[nodiscard]] auto claim() -> std::int64_t { return next_.fetch_add(1, std::memory_order_relaxed); }
+    [[nodiscard]] auto slot(std::int64_t seq) -> T & { return slots_[index(seq)].value; }
+
+    void publish(std::int64_t seq) { slots_[index(seq)].published.store(seq, std::memory_order_release); }
+    [[nodiscard]] auto available(std::int64_t seq) const -> bool
+    {
+        return slots_[index(seq)].published.load(std::memory_order_acquire) == seq;
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<std::int64_t> published{-1}; // sequence last written to this slot
+        T value{};
+    };
+
+    [[nodiscard]] auto index(std::int64_t seq) const -> std::size_t { return static_cast<std::size_t>(seq) & mask_; }
+
+    std::size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+    alignas(64) std::atomic<std::int64_t> next_{0};
+};
@@ -0,0 +1,82 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <ostream>
+#include <string_view>
+
+// Fixed-capacity, allocation-free text buffer built on std::to_chars.
+// Output that does not fit is truncated rather than reallocated.
+template <std::size_t Capacity>
+class FormatBuffer
+{
+public:
+    auto append(std::string_view text) -> FormatBuffer &
+    {
+        std::size_t n = std::min(text.size(), Capacity - size_);
+        text.copy(data_.data() + size_, n);
+        size_ += n;
+        return *this;
+    }
+
+    auto append(const char *text) -> FormatBuffer &
+    {
+        return append(std::string_view(text));
+    }
+
+    auto append(char c) -> FormatBuffer &
+    {
+        if (size_ < Capacity)
+            data_[size_++] = c;
+        return *this;
+    }
+
+    template <typename T>
+        requires(std::integral<T> && !std::same_as<T, char> && !std::same_as<T, bool>)
+    auto append(T value) -> FormatBuffer &
+    {
+        auto [end, ec] = std::to_chars(data_.data() + size_, data_.data() + Capacity, value);
+        if (ec == std::errc{})
+            size_ = static_cast<std::size_t>(end - data_.data());
+        return *this;
+    }
+
+    // Fixed-point floating value with `Precision` digits after the decimal point
+    template <int Precision = 2, std::floating_point T>
+    auto append_fixed(T value) -> FormatBuffer &
+    {
+        auto [end, ec] = std::to_chars(data_.data() + size_, data_.data() + Capacity, value,
+                                       std::chars_format::fixed, Precision);
+        if (ec == std::errc{})
+            size_ = static_cast<std::size_t>(end - data_.data());
+        return *this;
+    }
+
+    // Append all parts, then left-align them in a field of `Width` characters
+    template <std::size_t Width, typename... Parts>
+    auto append_field(const Parts &...parts) -> FormatBuffer &
+    {
+        std::size_t start = size_;
+        (append(parts), ...);
+        while (size_ - start < Width && size_ < Capacity)
+            data_[size_++] = ' ';
+        return *this;
+    }
+
+    void clear() { size_ = 0; }
+
+    [[nodiscard]] auto view() const -> std::string_view { return {data_.data(), size_}; }
+    [[nodiscard]] auto size() const -> std::size_t { return size_; }
+
+private:
+    std::array<char, Capacity> data_{};
+    std::size_t size_ = 0;
+};
+
+template <std::size_t Capacity>
+auto operator<<(std::ostream &os, const FormatBuffer<Capacity> &buf) -> std::ostream &
+{
+    return os.write(buf.view().data(), static_cast<std::streamsize>(buf.size()));
+}
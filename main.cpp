@@ -1,276 +1,663 @@
 #include <iostream>
-#include <mutex>
-#include <condition_variable>
-#include <vector>
-#include <thread>
-#include <chrono>
 #include <algorithm>
-#include "utils.h"
+#include <fstream>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "config.h"
+#include "format.h"
+#include "model.h"
+#include "monte_carlo.h"
+#include "profiles.h"
+
+// Lock on the shared-lock driver's state; each one is its own profile
+enum class StateLock
+{
+    Mutex,  // std::mutex: fastest hand-off, no ordering guarantee
+    Ticket, // FIFO ticket lock
+    Mcs     // FIFO MCS queue lock
+};
 
-// Enum for instance status
-enum class InstanceStatus
+// Switches accepted alongside the positional arguments
+struct Options
 {
-    Empty,
-    Active
+    bool virtual_clock = false; // run SilentVirtualProfile instead of WallClockProfile
+    bool verbose = false;       // with --virtual, print every event
+    bool seed_given = false;
+    std::uint64_t seed = 0;
+    std::string config_path;    // key=value file, hot-reloaded in wall-clock runs
+    bool model = false;         // print the queueing-model prediction next to the results
+    bool model_only = false;    // print the prediction and skip the simulation
+    std::string samples_path;   // CSV destination for the queue-depth time series
+    int sample_interval_ms = 1000;
+    std::size_t sample_capacity = 4096;
+    int replicas = 0;           // > 0: Monte Carlo mode with this many virtual-clock replicas
+    int threads = 0;            // worker threads for replicas, 0 = all cores
+    int rating_window = -1;     // -1 = keep config/default
+    int max_latency_ms = -1;
+    int regions = -1;
+    int region_penalty_ms = -1;
+    int latency_relax = -1;
+    int lookahead_ms = -1;
+    int bonus_lead_ms = -1;
+    int idle_spins = -1;        // -1 = keep config/default
+    int generator_threads = 0;  // 0 = keep config/default
+    int generator_batch = -1;
+    WallDriver driver = WallDriver::SharedLock; // how wall-clock threads coordinate
+    StateLock lock = StateLock::Mutex;
+    bool closed_loop = false;
+    int think_ms = -1;
+    std::optional<ArrivalCurve::Diurnal> diurnal; // arrival curve pieces; none = flat generator
+    std::vector<ArrivalCurve::Spike> spikes;
+    std::string arrival_file;
+    std::string scenario_path;  // timed events injected during the run
+    double speedup = 0.0;       // 0 = keep config/default
+    std::optional<WaitSlo> plan; // capacity planning: search instance counts against this SLO
+    double fork_at_s = -1.0;     // >= 0: what-if mode, branches fork from the state at this time
+    std::vector<Branch> branches;
 };
 
-// Helper function to convert InstanceStatus to string
-auto status_to_string(InstanceStatus status) -> std::string
+// "instances=20,rate=1.5"; either key may be left out
+auto parse_branch(std::string_view text, Branch &branch) -> bool
 {
-    switch (status)
+    branch.label = std::string(text);
+    while (!text.empty())
     {
-    case InstanceStatus::Empty:
-        return "empty";
-    case InstanceStatus::Active:
-        return "active";
-    default:
-        return "unknown";
+        auto comma = text.find(',');
+        std::string_view item = text.substr(0, comma);
+        auto eq = item.find('=');
+        if (eq == std::string_view::npos)
+            return false;
+        std::string_view key = item.substr(0, eq);
+        std::string value(item.substr(eq + 1));
+        if (key == "instances")
+            branch.instances = std::stoi(value);
+        else if (key == "rate")
+            branch.arrival_rate = std::stod(value);
+        else
+            return false;
+        text = comma == std::string_view::npos ? std::string_view{} : text.substr(comma + 1);
     }
+    return branch.instances >= 0 && branch.instances <= MAX_INSTANCES && branch.arrival_rate >= 0.0;
 }
 
-// Structure to represent a dungeon instance
-struct Instance
+// "p95:60" -> p95 wait <= 60 s; metrics are mean, p50, p95, p99
+auto parse_slo(std::string_view text, WaitSlo &slo) -> bool
 {
-    InstanceStatus status = InstanceStatus::Empty;
-    int served = 0;           // number of parties served
-    long long total_time = 0; // total time served
-};
-
-// Global simulation parameters
-int g_instances;               // number of concurrent dungeon instances
-int g_tanks, g_healers, g_dps; // available players
-int g_t1, g_t2;                // min/max time to complete dungeon
-int g_bonus_duration;          // in seconds, 0 = infinite
-
-// Shared state
-std::vector<Instance> instances;
-std::mutex state_mutex;
-std::mutex print_mutex;
-
-// Simulation control
-std::condition_variable player_available_cv;
-bool simulation_ended = false;
-bool bonus_mode_active = false;
+    auto colon = text.find(':');
+    if (colon == std::string_view::npos)
+        return false;
+    std::string_view metric = text.substr(0, colon);
+    if (metric == "mean")
+        slo.metric = &RunMetrics::wait_mean_s;
+    else if (metric == "p50")
+        slo.metric = &RunMetrics::wait_p50_s;
+    else if (metric == "p95")
+        slo.metric = &RunMetrics::wait_p95_s;
+    else if (metric == "p99")
+        slo.metric = &RunMetrics::wait_p99_s;
+    else
+        return false;
+    slo.label = metric == "mean" ? "mean" : metric == "p50" ? "p50" : metric == "p95" ? "p95" : "p99";
+    slo.limit_s = std::stod(std::string(text.substr(colon + 1)));
+    return slo.limit_s >= 0.0;
+}
 
-// Bonus player tracking
-int g_bonus_tanks_added = 0;
-int g_bonus_healers_added = 0;
-int g_bonus_dps_added = 0;
+void print_usage(const char *program)
+{
+    std::cerr << "Usage: " << program
+              << " <instances> <tanks> <healers> <dps> <t1> <t2> [bonus_duration] [options]\n"
+              << "       " << program << " --config=FILE [options]\n";
+    std::cerr << "  bonus_duration: seconds to generate bonus players (0 = infinite, omit = infinite)\n";
+    std::cerr << "Options:\n"
+              << "  --virtual     run on a simulated clock (single-threaded, requires bonus_duration > 0)\n"
+              << "  --verbose     with --virtual, print every event\n"
+              << "  --seed=N      RNG seed; fixes every instance's dungeon durations in any mode\n"
+              << "  --speedup=X   wall clock: run X times faster than real time; stats stay in simulated time\n"
+              << "  --config=FILE read parameters from FILE (positional arguments override it);\n"
+              << "                generator.* keys are reloaded whenever FILE changes\n"
+              << "  --model       print the M/G/c queueing prediction and compare it with the run\n"
+              << "  --model-only  print the prediction without simulating\n"
+              << "  --samples=FILE            write a queue-depth/utilization time series as CSV\n"
+              << "  --sample-interval-ms=N    sampling period (default 1000)\n"
+              << "  --sample-capacity=N       samples kept; oldest are overwritten (default 4096)\n"
+              << "  --replicas=K  run K seeded virtual-clock replicas in parallel and report 95% CIs\n"
+              << "  --threads=N   worker threads for --replicas (default: all cores)\n"
+              << "  --plan=M:S    find the fewest instances whose wait metric M (mean/p50/p95/p99) is <= S\n"
+              << "                seconds, averaged over --replicas runs (default 8); <instances> is ignored\n"
+              << "  --fork-at=S   what-if mode: run to S simulated seconds once, then clone that state\n"
+              << "                into every --branch and finish the branches in parallel\n"
+              << "  --branch=SPEC instances=N and/or rate=X (arrival factor), comma-separated; repeatable\n"
+              << "  --rating-window=N         match parties within +/-N rating of the anchor tank\n"
+              << "  --max-latency-ms=N        skip players above N ms latency to the instance\n"
+              << "  --regions=R               spread instances and players over R data centers\n"
+              << "  --region-penalty-ms=N     latency added per hop to a remote region (default 80)\n"
+              << "  --latency-relax=N         raise the latency cap N ms per second a player waits\n"
+              << "  --lookahead-ms=N          reserve an instance's next party N ms before its run ends\n"
+              << "  --bonus-lead-ms=N         start bonus generation when the initial players are forecast\n"
+              << "                            to run out within N ms, at the current party rate\n"
+              << "  --idle-spin=N             spin N rounds before an idle instance thread sleeps\n"
+              << "                            (default 2048, 0 on a single core)\n"
+              << "  --generator-threads=N     N threads roll generator waves, each at the full rate\n"
+              << "  --generator-batch=N       a generator thread hands over its players N at a time\n"
+              << "                            (default 0: every wave as it is rolled)\n"
+              << "  --lock=KIND               shared-lock driver's state lock: mutex (default), or the\n"
+              << "                            FIFO queue locks ticket or mcs\n"
+              << "  --matcher-thread          one matcher thread owns the queues; instances message it\n"
+              << "  --pipeline                arrival/match/dispatch/complete stages linked by ring buffers\n"
+              << "  --closed-loop             player population: players re-queue after each run\n"
+              << "  --think-ms=N              closed loop: mean think time before re-queueing (default 5000)\n"
+              << "  --diurnal=A[,P[,PEAK]]    scale the wave rate by 1 + A cos(2 pi (t - PEAK) / P), t in seconds\n"
+              << "                            (P default 86400, PEAK default 0)\n"
+              << "  --spike=T,F[,D]           at T s multiply the wave rate by F, decaying over D s (default 600);\n"
+              << "                            may be repeated\n"
+              << "  --arrival-file=FILE       piecewise-linear rate multiplier, one \"seconds multiplier\" per line\n"
+              << "  --scenario=FILE           inject timed events (add players, instances offline/online,\n"
+              << "                            arrival rate per role); see scenario.h for the format\n";
+}
 
-auto can_form_party() -> bool
+// Split "--name=value" into name and value; value is empty when absent
+auto split_option(std::string_view arg) -> std::pair<std::string_view, std::string_view>
 {
-    return (g_tanks >= 1 && g_healers >= 1 && g_dps >= 3);
+    arg.remove_prefix(2);
+    auto eq = arg.find('=');
+    if (eq == std::string_view::npos)
+        return {arg, {}};
+    return {arg.substr(0, eq), arg.substr(eq + 1)};
 }
 
-void instance_loop(int instance_id)
+void print_header(const SimulationParams &params, const Options &options)
 {
-    while (true)
+    FormatBuffer<768> header;
+    header.append("=== Starting LFG Simulation ===\n")
+        .append_field<15>("Instances:")
+        .append(params.instances)
+        .append('\n')
+        .append_field<15>("Players:")
+        .append("Tanks = ").append(params.tanks)
+        .append(", Healers = ").append(params.healers)
+        .append(", DPS = ").append(params.dps)
+        .append('\n')
+        .append_field<15>("Clear time:")
+        .append('[').append(params.t1).append(',').append(params.t2).append("] seconds\n")
+        .append_field<15>("Party:")
+        .append(params.party.tanks).append(" Tank, ")
+        .append(params.party.healers).append(" Healer, ")
+        .append(params.party.dps).append(" DPS\n")
+        .append_field<15>("Bonus mode:");
+    if (params.bonus_duration == 0)
+        header.append("Infinite");
+    else
+        header.append(params.bonus_duration).append(" seconds");
+    if (params.rating_window > 0 || params.regions > 1)
     {
-        // Try to form a party
-        std::string status_snapshot;
-
+        header.append('\n').append_field<15>("Matching:");
+        if (params.rating_window > 0)
+            header.append("rating +/-").append(params.rating_window).append(", ");
+        header.append(params.regions).append(" region(s)");
+        if (params.max_latency_ms > 0)
         {
-            std::unique_lock lock(state_mutex);
-
-            // If can't form party and not in bonus mode yet, activate it
-            if (!can_form_party() && !bonus_mode_active)
-            {
-                bonus_mode_active = true;
-                {
-                    std::scoped_lock print_lock(print_mutex);
-                    std::cout << "\n[SYSTEM] Initial players exhausted. Activating bonus player generation...\n\n";
-                }
-                // Wake up the player generator thread
-                player_available_cv.notify_all();
-            }
+            header.append(", latency <= ").append(params.max_latency_ms).append("ms");
+            if (params.latency_relax_ms_per_s > 0)
+                header.append(" +").append(params.latency_relax_ms_per_s).append("ms per s waited");
+        }
+    }
+    if (params.closed_loop)
+    {
+        header.append('\n').append_field<15>("Population:")
+            .append("closed loop, mean think time ").append(params.think_ms).append("ms");
+    }
+    if (params.arrivals.active())
+    {
+        const ArrivalCurve &curve = params.arrivals;
+        header.append('\n').append_field<15>("Arrivals:");
+        if (curve.diurnal.amplitude > 0.0)
+        {
+            header.append("diurnal +/-").append_fixed<0>(curve.diurnal.amplitude * 100.0)
+                .append("% over ").append_fixed<0>(curve.diurnal.period_s).append("s, ");
+        }
+        if (!curve.points.empty())
+            header.append(curve.points.size()).append("-point schedule, ");
+        header.append(curve.spikes.size()).append(" spike(s), at most x").append_fixed<2>(curve.bound());
+    }
+    if (!params.scenario.empty())
+    {
+        header.append('\n').append_field<15>("Scenario:")
+            .append(params.scenario.size()).append(" event(s) from ").append(options.scenario_path);
+    }
+    if (params.bonus_lead_ms > 0 && !params.closed_loop)
+    {
+        header.append('\n').append_field<15>("Bonus lead:")
+            .append("start generating ").append(params.bonus_lead_ms).append("ms before the initial players run out");
+    }
+    if (params.lookahead_ms > 0)
+    {
+        header.append('\n').append_field<15>("Lookahead:")
+            .append("reserve next party ").append(params.lookahead_ms).append("ms before a run ends");
+    }
+    if (options.driver == WallDriver::CentralMatcher)
+        header.append('\n').append_field<15>("Driver:").append("central matcher thread");
+    else if (options.driver == WallDriver::Pipeline)
+        header.append('\n').append_field<15>("Driver:").append("staged pipeline");
+    if (params.generator_threads > 1 || params.generator_batch > 0)
+    {
+        header.append('\n').append_field<15>("Generators:").append(params.generator_threads).append(" thread(s), ");
+        if (params.generator_batch > 0)
+            header.append("batches of ").append(params.generator_batch).append(" players");
+        else
+            header.append("every wave handed over");
+    }
+    if (options.lock == StateLock::Ticket)
+        header.append('\n').append_field<15>("State lock:").append("FIFO ticket lock");
+    else if (options.lock == StateLock::Mcs)
+        header.append('\n').append_field<15>("State lock:").append("FIFO MCS queue lock");
+    if (options.virtual_clock)
+    {
+        header.append('\n')
+            .append_field<15>("Clock:")
+            .append("virtual (seed ").append(params.seed).append(')');
+    }
+    else if (params.speedup != 1.0)
+    {
+        header.append('\n')
+            .append_field<15>("Clock:")
+            .append("wall, ").append_fixed<1>(params.speedup).append("x compressed (times are simulated)");
+    }
+    header.append("\n================================\n\n");
 
-            // Wait until a party can be formed or simulation ends
-            player_available_cv.wait(lock, []() -> bool
-                                     { return can_form_party() || simulation_ended; });
+    std::scoped_lock print_lock(ConsoleLog::print_mutex);
+    std::cout << header;
+}
 
-            if (simulation_ended && !can_form_party())
-            {
-                instances[instance_id].status = InstanceStatus::Empty;
-                break;
-            }
+using SummaryBuffer = FormatBuffer<2048>;
 
-            // Form party atomically
-            g_tanks -= 1;
-            g_healers -= 1;
-            g_dps -= 3;
-            instances[instance_id].status = InstanceStatus::Active;
+void append_quantiles(SummaryBuffer &out, const QuantileSketch &sketch)
+{
+    out.append("mean ").append_fixed<1>(sketch.mean())
+        .append(", p50 ").append_fixed<1>(sketch.quantile(0.50))
+        .append(", p95 ").append_fixed<1>(sketch.quantile(0.95))
+        .append(", p99 ").append_fixed<1>(sketch.quantile(0.99)).append('\n');
+}
 
-            // Capture status snapshot while still holding the lock
-            status_snapshot = "[Status] ";
-            for (int i = 0; i < g_instances; ++i)
-            {
-                std::string inst_str = "I" + std::to_string(i) + ":" + status_to_string(instances[i].status);
-                status_snapshot += pad(inst_str, 12);
-            }
-        }
+// Every instance keeps its own sketches; they are merged only here
+void append_waits(SummaryBuffer &out, const SimulationResult &result)
+{
+    QuantileSketch waits = merged_waits(result);
+    out.append("\nPlayer wait (s): ");
+    append_quantiles(out, waits);
+    for (int r = 0; r < ROLE_COUNT; ++r)
+    {
+        out.append("  ").append_field<9>(role_to_string(static_cast<Role>(r)), ':');
+        append_quantiles(out, merged_waits(result, r));
+    }
+    out.append("Dungeon run (s): ");
+    append_quantiles(out, merged_runs(result));
 
-        // Simulate dungeon run
-        int duration = random_int(g_t1, g_t2);
+    std::size_t bytes = 0;
+    for (const InstanceDistributions &d : result.distributions)
+    {
+        bytes += d.runs_s.memory_bytes();
+        for (const QuantileSketch &sketch : d.waits_s)
+            bytes += sketch.memory_bytes();
+    }
+    out.append("  (").append(waits.count()).append(" waits in ").append(result.distributions.size() * (ROLE_COUNT + 1))
+        .append(" quantile sketches, ").append_fixed<1>(static_cast<double>(bytes) / 1024.0).append(" KB)\n");
+    if (result.mean_latency_ms > 0.0)
+        out.append("Mean matched latency: ").append_fixed<1>(result.mean_latency_ms).append(" ms\n");
+}
 
-        // Print atomically
-        {
-            std::scoped_lock print_lock(print_mutex);
-            std::cout << "[I" << instance_id << "] Dungeon started (" << duration << "s)\n";
-            std::cout << status_snapshot << '\n';
-        }
+void append_handoffs(SummaryBuffer &out, const SimulationResult &result)
+{
+    if (result.handoffs == 0)
+        return;
+    double mean = result.idle_between_runs_ms / static_cast<double>(result.handoffs);
+    out.append("Instance idle between runs (ms): mean ").append_fixed<3>(mean)
+        .append(", max ").append_fixed<3>(result.idle_between_runs_max_ms)
+        .append(" over ").append(result.handoffs).append(" handoffs\n");
+}
 
-        std::this_thread::sleep_for(std::chrono::seconds(duration));
+void append_scenario(SummaryBuffer &out, const SimulationResult &result)
+{
+    if (result.scenario_scripted == 0)
+        return;
+    const auto &added = result.scenario_players;
+    out.append("\nScenario: ").append(result.scenario_events).append(" of ").append(result.scenario_scripted)
+        .append(" event(s) applied; players added - Tanks: ").append(added[0])
+        .append(", Healers: ").append(added[1])
+        .append(", DPS: ").append(added[2]).append('\n');
+}
 
-        // Update instance stats
-        {
-            std::unique_lock lock(state_mutex);
-            instances[instance_id].served += 1;
-            instances[instance_id].total_time += duration;
-            instances[instance_id].status = InstanceStatus::Empty;
-
-            // Capture status snapshot
-            status_snapshot = "[Status] ";
-            for (int i = 0; i < g_instances; ++i)
-            {
-                std::string inst_str = "I" + std::to_string(i) + ":" + status_to_string(instances[i].status);
-                status_snapshot += pad(inst_str, 12);
-            }
-        }
+void append_population(SummaryBuffer &out, const PopulationStats &population)
+{
+    if (population.players == 0)
+        return;
+    // Small populations are dominated by the first slab, so also quote the
+    // marginal cost that a million more players would add
+    double per_player = static_cast<double>(population.memory_bytes) / static_cast<double>(population.players);
+    double per_million_mb = static_cast<double>(PlayerPopulation::BYTES_PER_PLAYER) * 1e6 / (1024.0 * 1024.0);
+    out.append("\nClosed-loop population: ").append(population.players).append(" players in ")
+        .append_fixed<1>(static_cast<double>(population.memory_bytes) / (1024.0 * 1024.0)).append(" MB (")
+        .append_fixed<1>(per_player).append(" bytes/player; ")
+        .append(PlayerPopulation::BYTES_PER_PLAYER).append(" bytes or ")
+        .append_fixed<1>(per_million_mb).append(" MB per million more)\n")
+        .append("  Parties joined per player: mean ").append_fixed<2>(population.runs_mean)
+        .append(", min ").append(population.runs_min)
+        .append(", max ").append(population.runs_max).append('\n');
+}
 
-        // Print atomically
-        {
-            std::scoped_lock print_lock(print_mutex);
-            std::cout << "[I" << instance_id << "] Dungeon completed (" << duration << "s)\n";
-            std::cout << status_snapshot << '\n';
-        }
+// Per-stage throughput of the pipeline driver
+void append_stages(SummaryBuffer &out, const SimulationResult &result)
+{
+    if (result.stages.empty())
+        return;
+    double seconds = static_cast<double>(std::max<SimTime>(result.elapsed_ms, 1)) / 1000.0;
+    out.append("\nPipeline stages:\n");
+    for (const StageStats &stage : result.stages)
+    {
+        out.append("  ").append_field<10>(stage.name, ':')
+            .append(stage.events).append(" events, ")
+            .append_fixed<2>(static_cast<double>(stage.events) / seconds).append("/s, wait ")
+            .append_fixed<1>(stage.latency_us).append(" us\n");
     }
 }
 
-void player_generator_thread()
+// Explain the remaining players: which shortage kept instances idle, and for how long
+void append_bottleneck(SummaryBuffer &out, const BottleneckStats &stats)
 {
-    // Wait until bonus mode is activated
+    double idle_total = 0.0;
+    int worst = 0;
+    for (int r = 0; r < ROLE_COUNT; ++r)
+    {
+        idle_total += stats.idle_instance_s[r];
+        if (stats.idle_instance_s[r] > stats.idle_instance_s[worst])
+            worst = r;
+    }
+
+    out.append("\nBottleneck analysis:\n")
+        .append("  Idle instance-seconds by missing role:\n");
+    for (int r = 0; r < ROLE_COUNT; ++r)
+    {
+        double share = idle_total > 0.0 ? stats.idle_instance_s[r] / idle_total * 100.0 : 0.0;
+        out.append("    ").append_field<9>(role_to_string(static_cast<Role>(r)), ':')
+            .append_fixed<1>(stats.idle_instance_s[r]).append(" (")
+            .append_fixed<1>(share).append("%)\n");
+    }
+    if (stats.initial_exhausted_ms >= 0 && stats.bonus_started_ms >= 0)
     {
-        std::unique_lock lock(state_mutex);
-        player_available_cv.wait(lock, []() -> bool
-                                 { return bonus_mode_active || simulation_ended; });
-        if (simulation_ended)
-            return;
+        out.append("  Idle in the hand-over to bonus players: ").append_fixed<1>(stats.transition_idle_instance_s)
+            .append(" (initial players gone at ").append_fixed<1>(static_cast<double>(stats.initial_exhausted_ms) / 1000.0)
+            .append(" s, generation from ").append_fixed<1>(static_cast<double>(stats.bonus_started_ms) / 1000.0)
+            .append(" s)\n");
     }
+    out.append("  Party-seconds waiting for an instance: ")
+        .append_fixed<1>(stats.waiting_party_s).append('\n')
+        .append("  Verdict: ");
+    if (idle_total == 0.0 && stats.waiting_party_s == 0.0)
+        out.append("no contention observed\n");
+    else if (stats.waiting_party_s > idle_total)
+        out.append("instance shortage - adding instances raises throughput\n");
+    else
+        out.append(role_to_string(static_cast<Role>(worst)))
+            .append(" shortage - more of this role raises throughput\n");
+}
 
-    // Configuration for player generation
-    const int check_interval_ms = 500;         // check every 500 ms
-    const double generation_probability = 0.3; // 30% chance to generate players each check
+void print_summary(const SimulationResult &result)
+{
+    int total_served = 0;
+    long long total_time = 0;
+    FormatBuffer<128> line;
+    std::cout << "\n=== Simulation Summary ===\n";
+    for (std::size_t i = 0; i < result.instances.size(); ++i)
+    {
+        const Instance &inst = result.instances[i];
+        line.clear();
+        line.append("Instance ").append(i);
+        if (result.regions > 1)
+            line.append(" [region ").append(i % static_cast<std::size_t>(result.regions)).append(']');
+        line.append(": Served ").append(inst.served)
+            .append(" parties, Total time ").append(inst.total_time)
+            .append(" seconds\n");
+        std::cout << line;
+        total_served += inst.served;
+        total_time += inst.total_time;
+    }
 
-    // Balance: Tanks and healers are rarer than DPS
-    const int min_tanks_per_wave = 0;
-    const int max_tanks_per_wave = 2;
+    int bonus_total = result.bonus_tanks_added + result.bonus_healers_added + result.bonus_dps_added;
+    SummaryBuffer summary;
+    summary.append("--------------------------\n")
+        .append("Total parties served: ").append(total_served).append('\n')
+        .append("Total time spent: ").append(total_time).append(" seconds\n")
+        .append("\nBonus players generated:\n")
+        .append("  Tanks: ").append(result.bonus_tanks_added).append('\n')
+        .append("  Healers: ").append(result.bonus_healers_added).append('\n')
+        .append("  DPS: ").append(result.bonus_dps_added).append('\n')
+        .append("  Total: ").append(bonus_total).append('\n')
+        .append("\nRemaining players:\n")
+        .append("  Tanks: ").append(result.remaining_tanks).append('\n')
+        .append("  Healers: ").append(result.remaining_healers).append('\n')
+        .append("  DPS: ").append(result.remaining_dps).append('\n');
+    append_waits(summary, result);
+    append_handoffs(summary, result);
+    append_stages(summary, result);
+    append_population(summary, result.population);
+    append_scenario(summary, result);
+    append_bottleneck(summary, result.bottleneck);
+    summary.append("==========================\n");
+    std::cout << summary;
+}
 
-    const int min_healers_per_wave = 0;
-    const int max_healers_per_wave = 2;
+template <typename Sim>
+auto run_wall_clock(const SimulationParams &params, const Options &options) -> SimulationResult
+{
+    Sim sim(params);
 
-    const int min_dps_per_wave = 0;
-    const int max_dps_per_wave = 5;
+    // Hot reload of generator rates for long-running simulations
+    ConfigWatcher watcher(options.config_path, params, [&sim](const GeneratorConfig &gen)
+                          { sim.set_generator(gen); });
+    if (!options.config_path.empty())
+    {
+        std::string error;
+        if (!watcher.start(error))
+            std::cerr << "Warning: " << error << "; config changes will be ignored\n";
+    }
 
-    auto start_time = std::chrono::steady_clock::now();
+    sim.run();
+    watcher.stop();
+    return sim.result();
+}
 
-    while (true)
+auto main(int argc, char *argv[]) -> int
+{
+    // Separate positional arguments from --options
+    std::vector<std::string> positional;
+    Options options;
+    for (int i = 1; i < argc; ++i)
     {
-        // Check if bonus duration has elapsed
-        if (g_bonus_duration > 0)
+        std::string_view arg = argv[i];
+        if (!arg.starts_with("--"))
         {
-            auto current_time = std::chrono::steady_clock::now();
-            auto elapsed_seconds = std::chrono::duration_cast<std::chrono::seconds>(
-                                       current_time - start_time)
-                                       .count();
-            if (elapsed_seconds >= g_bonus_duration)
-            {
-                // Signal all threads to end
-                {
-                    std::unique_lock lock(state_mutex);
-                    simulation_ended = true;
-                }
-                player_available_cv.notify_all();
-                break;
-            }
+            positional.emplace_back(arg);
+            continue;
         }
 
-        // Random chance to generate players
-        double roll = static_cast<double>(random_int(0, 100)) / 100.0;
-        if (roll < generation_probability)
+        auto [name, value] = split_option(arg);
+        try
         {
-            int new_tanks = random_int(min_tanks_per_wave, max_tanks_per_wave);
-            int new_healers = random_int(min_healers_per_wave, max_healers_per_wave);
-            int new_dps = random_int(min_dps_per_wave, max_dps_per_wave);
-
-            // Only add players if at least one is generated
-            if (new_tanks > 0 || new_healers > 0 || new_dps > 0)
+            if (name == "virtual")
+                options.virtual_clock = true;
+            else if (name == "verbose")
+                options.verbose = true;
+            else if (name == "model")
+                options.model = true;
+            else if (name == "matcher-thread")
+                options.driver = WallDriver::CentralMatcher;
+            else if (name == "pipeline")
+                options.driver = WallDriver::Pipeline;
+            else if (name == "lock")
+            {
+                if (value == "mutex")
+                    options.lock = StateLock::Mutex;
+                else if (value == "ticket")
+                    options.lock = StateLock::Ticket;
+                else if (value == "mcs")
+                    options.lock = StateLock::Mcs;
+                else
+                    throw std::invalid_argument("lock");
+            }
+            else if (name == "closed-loop")
+                options.closed_loop = true;
+            else if (name == "think-ms")
+                options.think_ms = std::stoi(std::string(value));
+            else if (name == "diurnal")
+            {
+                ArrivalCurve::Diurnal diurnal;
+                if (!parse_diurnal(value, diurnal))
+                    throw std::invalid_argument("diurnal");
+                options.diurnal = diurnal;
+            }
+            else if (name == "spike")
             {
-                {
-                    std::scoped_lock lock(state_mutex);
-                    g_tanks += new_tanks;
-                    g_healers += new_healers;
-                    g_dps += new_dps;
-
-                    // Track bonus players added
-                    g_bonus_tanks_added += new_tanks;
-                    g_bonus_healers_added += new_healers;
-                    g_bonus_dps_added += new_dps;
-                }
-
-                // Print notification
-                {
-                    std::scoped_lock print_lock(print_mutex);
-                    std::cout << "[Player Generator] Added players - "
-                              << "Tanks: " << new_tanks
-                              << ", Healers: " << new_healers
-                              << ", DPS: " << new_dps << "\n";
-                }
-
-                // Notify waiting instance threads
-                player_available_cv.notify_all();
+                ArrivalCurve::Spike spike;
+                if (!parse_spike(value, spike))
+                    throw std::invalid_argument("spike");
+                options.spikes.push_back(spike);
+            }
+            else if (name == "arrival-file" && !value.empty())
+                options.arrival_file = value;
+            else if (name == "scenario" && !value.empty())
+                options.scenario_path = value;
+            else if (name == "speedup")
+            {
+                options.speedup = std::stod(std::string(value));
+                if (!(options.speedup > 0.0))
+                    throw std::invalid_argument("speedup");
+            }
+            else if (name == "model-only")
+                options.model_only = true;
+            else if (name == "config" && !value.empty())
+                options.config_path = value;
+            else if (name == "samples" && !value.empty())
+                options.samples_path = value;
+            else if (name == "sample-interval-ms")
+                options.sample_interval_ms = std::stoi(std::string(value));
+            else if (name == "sample-capacity")
+                options.sample_capacity = std::stoul(std::string(value));
+            else if (name == "plan")
+            {
+                WaitSlo slo;
+                if (!parse_slo(value, slo))
+                    throw std::invalid_argument("plan");
+                options.plan = slo;
+            }
+            else if (name == "fork-at")
+                options.fork_at_s = std::stod(std::string(value));
+            else if (name == "branch")
+            {
+                Branch branch;
+                if (!parse_branch(value, branch))
+                    throw std::invalid_argument("branch");
+                options.branches.push_back(branch);
+            }
+            else if (name == "replicas")
+                options.replicas = std::stoi(std::string(value));
+            else if (name == "threads")
+                options.threads = std::stoi(std::string(value));
+            else if (name == "rating-window")
+                options.rating_window = std::stoi(std::string(value));
+            else if (name == "max-latency-ms")
+                options.max_latency_ms = std::stoi(std::string(value));
+            else if (name == "regions")
+                options.regions = std::stoi(std::string(value));
+            else if (name == "region-penalty-ms")
+                options.region_penalty_ms = std::stoi(std::string(value));
+            else if (name == "latency-relax")
+                options.latency_relax = std::stoi(std::string(value));
+            else if (name == "lookahead-ms")
+                options.lookahead_ms = std::stoi(std::string(value));
+            else if (name == "bonus-lead-ms")
+            {
+                options.bonus_lead_ms = std::stoi(std::string(value));
+                if (options.bonus_lead_ms < 0)
+                    throw std::invalid_argument("bonus-lead-ms");
+            }
+            else if (name == "idle-spin")
+            {
+                options.idle_spins = std::stoi(std::string(value));
+                if (options.idle_spins < 0)
+                    throw std::invalid_argument("idle-spin");
+            }
+            else if (name == "generator-threads")
+            {
+                options.generator_threads = std::stoi(std::string(value));
+                if (options.generator_threads < 1)
+                    throw std::invalid_argument("generator-threads");
+            }
+            else if (name == "generator-batch")
+            {
+                options.generator_batch = std::stoi(std::string(value));
+                if (options.generator_batch < 0)
+                    throw std::invalid_argument("generator-batch");
+            }
+            else if (name == "seed")
+            {
+                options.seed = std::stoull(std::string(value));
+                options.seed_given = true;
+            }
+            else
+            {
+                std::cerr << "Error: Unknown option " << arg << "\n";
+                print_usage(argv[0]);
+                return 1;
             }
         }
-
-        // Sleep before next check
-        std::this_thread::sleep_for(std::chrono::milliseconds(check_interval_ms));
-    }
-
-    {
-        std::scoped_lock print_lock(print_mutex);
-        if (g_bonus_duration > 0)
+        catch (const std::logic_error &e)
         {
-            std::cout << "\n[SYSTEM] Bonus duration ended. Finishing remaining dungeons...\n\n";
+            std::cerr << "Error: Invalid value for " << arg << "\n";
+            return 1;
         }
     }
-}
 
-auto main(int argc, char *argv[]) -> int
-{
-    if (argc != 7 && argc != 8)
+    bool from_config = !options.config_path.empty();
+    if (positional.size() != 6 && positional.size() != 7 && !(from_config && positional.empty()))
     {
-        std::cerr << "Usage: " << argv[0]
-                  << " <instances> <tanks> <healers> <dps> <t1> <t2>\n";
-        std::cerr << "  bonus_duration: seconds to generate bonus players (0 = infinite, omit = infinite)\n";
+        print_usage(argv[0]);
         return 1;
     }
 
+    SimulationParams params;
+    if (from_config)
+    {
+        std::string error;
+        if (!load_config(options.config_path, params, error))
+        {
+            std::cerr << "Error: " << error << "\n";
+            return 1;
+        }
+    }
+
     // Parse command-line arguments
     try
     {
-        g_instances = std::stoi(argv[1]);
-        g_tanks = std::stoi(argv[2]);
-        g_healers = std::stoi(argv[3]);
-        g_dps = std::stoi(argv[4]);
-        g_t1 = std::stoi(argv[5]);
-        g_t2 = std::stoi(argv[6]);
+        if (!positional.empty())
+        {
+            params.instances = std::stoi(positional[0]);
+            params.tanks = std::stoi(positional[1]);
+            params.healers = std::stoi(positional[2]);
+            params.dps = std::stoi(positional[3]);
+            params.t1 = std::stoi(positional[4]);
+            params.t2 = std::stoi(positional[5]);
+        }
 
-        if (argc == 8)
+        if (positional.size() == 7)
         {
-            g_bonus_duration = std::stoi(argv[7]);
+            params.bonus_duration = std::stoi(positional[6]);
         }
-        else
+        else if (!from_config)
         {
-            g_bonus_duration = 0; // infinite
+            params.bonus_duration = 0; // infinite
         }
     }
     catch (const std::invalid_argument &e)
@@ -285,133 +672,350 @@ auto main(int argc, char *argv[]) -> int
     }
 
     // Validate all parameters are non-negative
-    if (g_instances < 1 || g_tanks < 0 || g_healers < 0 || g_dps < 0)
+    if (params.instances < 1 || params.tanks < 0 || params.healers < 0 || params.dps < 0)
     {
         std::cerr << "Error: Instances must be >= 1 and players must be >= 0\n";
         return 1;
     }
 
-    constexpr int MAX_INSTANCES = 100;
-    if (g_instances > MAX_INSTANCES)
+    if (params.instances > MAX_INSTANCES)
     {
         std::cerr << "Error: Too many instances (max: " << MAX_INSTANCES << ")\n";
         return 1;
     }
 
+    if (options.closed_loop)
+        params.closed_loop = true;
+    if (options.think_ms >= 0)
+        params.think_ms = options.think_ms;
+    if (params.think_ms < 0)
+    {
+        std::cerr << "Error: --think-ms must be >= 0\n";
+        return 1;
+    }
+
+    // A closed population is stored compactly, so it may be much larger
     constexpr int MAX_PLAYERS = 10000;
-    if (g_tanks > MAX_PLAYERS || g_healers > MAX_PLAYERS || g_dps > MAX_PLAYERS)
+    constexpr int MAX_POPULATION = 10'000'000;
+    const int max_players = params.closed_loop ? MAX_POPULATION : MAX_PLAYERS;
+    if (params.tanks > max_players || params.healers > max_players || params.dps > max_players)
     {
-        std::cerr << "Error: Player count exceeds maximum (" << MAX_PLAYERS << ")\n";
+        std::cerr << "Error: Player count exceeds maximum (" << max_players << ")\n";
         return 1;
     }
 
     // Validate dungeon time range
-    if (g_t1 < 1 || g_t2 < 1 || g_t1 > g_t2)
+    if (params.t1 < 1 || params.t2 < 1 || params.t1 > params.t2)
     {
         std::cerr << "Error: Invalid time range. Need 1 <= t1 <= t2\n";
         return 1;
     }
 
     // Validate bonus duration
-    if (g_bonus_duration < 0)
+    if (params.bonus_duration < 0)
     {
         std::cerr << "Error: bonus_duration must be >= 0 (0 = infinite)\n";
         return 1;
     }
 
-    // Clamp times to valid range
-    int original_t2 = g_t2;
-    int original_t1 = g_t1;
+    if (options.rating_window >= 0)
+        params.rating_window = options.rating_window;
+    if (options.max_latency_ms >= 0)
+        params.max_latency_ms = options.max_latency_ms;
+    if (options.regions >= 0)
+        params.regions = options.regions;
+    if (options.region_penalty_ms >= 0)
+        params.region_penalty_ms = options.region_penalty_ms;
+    if (options.latency_relax >= 0)
+        params.latency_relax_ms_per_s = options.latency_relax;
+    if (params.rating_window < 0 || params.max_latency_ms < 0 || params.region_penalty_ms < 0 ||
+        params.latency_relax_ms_per_s < 0)
+    {
+        std::cerr << "Error: matching settings must be >= 0\n";
+        return 1;
+    }
+    if (params.regions < 1 || params.regions > params.instances)
+    {
+        std::cerr << "Error: regions must be between 1 and the number of instances\n";
+        return 1;
+    }
 
-    g_t2 = std::clamp(g_t2, 1, 15);
-    g_t1 = std::clamp(g_t1, 1, g_t2);
+    if (options.lookahead_ms >= 0)
+        params.lookahead_ms = options.lookahead_ms;
+    if (options.idle_spins >= 0)
+        params.idle_spins = options.idle_spins;
+    if (params.idle_spins < -1)
+    {
+        std::cerr << "Error: idle_spins must be >= 0 (-1 = default)\n";
+        return 1;
+    }
+    if (params.lookahead_ms < 0)
+    {
+        std::cerr << "Error: --lookahead-ms must be >= 0\n";
+        return 1;
+    }
+    if (options.bonus_lead_ms >= 0)
+        params.bonus_lead_ms = options.bonus_lead_ms;
+    if (params.bonus_lead_ms < 0)
+    {
+        std::cerr << "Error: bonus_lead_ms must be >= 0\n";
+        return 1;
+    }
+    if (options.generator_threads > 0)
+        params.generator_threads = options.generator_threads;
+    if (options.generator_batch >= 0)
+        params.generator_batch = options.generator_batch;
+    if (params.generator_threads < 1 || params.generator_threads > MAX_GENERATOR_THREADS ||
+        params.generator_batch < 0)
+    {
+        std::cerr << "Error: generator_threads must be between 1 and " << MAX_GENERATOR_THREADS
+                  << " and generator_batch >= 0\n";
+        return 1;
+    }
+
+    if (options.diurnal)
+        params.arrivals.diurnal = *options.diurnal;
+    params.arrivals.spikes.insert(params.arrivals.spikes.end(), options.spikes.begin(), options.spikes.end());
+    if (!options.arrival_file.empty())
+    {
+        std::string error;
+        if (!load_arrival_points(options.arrival_file, params.arrivals.points, error))
+        {
+            std::cerr << "Error: " << error << "\n";
+            return 1;
+        }
+    }
+
+    if (!options.scenario_path.empty())
+    {
+        std::string error;
+        if (!load_scenario(options.scenario_path, params.scenario, error))
+        {
+            std::cerr << "Error: " << error << "\n";
+            return 1;
+        }
+    }
+
+    if (options.replicas < 0 || options.threads < 0)
+    {
+        std::cerr << "Error: --replicas and --threads must be >= 0\n";
+        return 1;
+    }
+    if (options.plan && options.replicas == 0)
+        options.replicas = 8;
+    if (options.fork_at_s >= 0.0 || !options.branches.empty())
+    {
+        if (options.fork_at_s < 0.0 || options.branches.empty() || options.replicas > 0)
+        {
+            std::cerr << "Error: what-if mode needs --fork-at=S and at least one --branch, without --replicas/--plan\n";
+            return 1;
+        }
+        options.virtual_clock = true;
+    }
+    if (options.replicas > 0)
+        options.virtual_clock = true;
+
+    if (options.speedup > 0.0)
+        params.speedup = options.speedup;
+    if (!(params.speedup >= 1.0) || params.speedup > 1e6)
+    {
+        std::cerr << "Error: speedup must be between 1 and 1000000\n";
+        return 1;
+    }
+    if (options.virtual_clock && params.speedup != 1.0)
+    {
+        std::cerr << "Error: --speedup applies to wall-clock runs; --virtual does not wait at all\n";
+        return 1;
+    }
 
-    if (g_t1 != original_t1)
+    if (options.driver != WallDriver::SharedLock)
+    {
+        if (options.virtual_clock)
+        {
+            std::cerr << "Error: --matcher-thread and --pipeline are wall-clock drivers; drop --virtual/--replicas\n";
+            return 1;
+        }
+        if (params.lookahead_ms > 0)
+        {
+            std::cerr << "Error: --lookahead-ms needs the default shared-lock driver\n";
+            return 1;
+        }
+    }
+    if (options.lock != StateLock::Mutex && (options.virtual_clock || options.driver != WallDriver::SharedLock))
+    {
+        std::cerr << "Error: --lock applies to the default shared-lock driver; the others do not contend on it\n";
+        return 1;
+    }
+    // Pipeline dispatch hands a party to whichever instance claims it first
+    if (options.driver == WallDriver::Pipeline && params.regions > 1)
+    {
+        std::cerr << "Error: --pipeline does not support --regions\n";
+        return 1;
+    }
+    if (params.closed_loop && (options.driver == WallDriver::Pipeline || params.rating_window > 0 || params.regions > 1))
+    {
+        std::cerr << "Error: --closed-loop does not support --pipeline or attribute matching\n";
+        return 1;
+    }
+    // The virtual clock and the pipeline's single-producer arrival ring take one generator
+    bool parallel_generators = params.generator_threads > 1 || params.generator_batch > 0;
+    if (parallel_generators && (options.virtual_clock || options.driver == WallDriver::Pipeline))
+    {
+        std::cerr << "Error: --generator-threads/--generator-batch need the shared-lock or --matcher-thread driver\n";
+        return 1;
+    }
+    if (params.generator_threads > 1 && params.closed_loop)
     {
-        std::cout << "Note: t1 clamped from " << original_t1 << " to " << g_t1 << "\n";
+        std::cerr << "Error: a closed loop generates no players; drop --generator-threads\n";
+        return 1;
     }
-    if (g_t2 != original_t2)
+    // The injector edits the shared state directly
+    if (!params.scenario.empty() && options.driver != WallDriver::SharedLock)
     {
-        std::cout << "Note: t2 clamped from " << original_t2 << " to " << g_t2 << " (max: 15)\n";
+        std::cerr << "Error: --scenario needs the default shared-lock driver or --virtual\n";
+        return 1;
     }
 
-    // Initialize dungeon instances
-    instances.assign(g_instances, Instance{});
+    // A simulated clock never waits, so an infinite run would never return
+    if (options.virtual_clock && params.bonus_duration == 0)
+    {
+        std::cerr << "Error: --virtual needs a finite bonus_duration (> 0)\n";
+        return 1;
+    }
+
+    // Clamp times to valid range
+    int original_t2 = params.t2;
+    int original_t1 = params.t1;
+
+    params.t2 = std::clamp(params.t2, 1, 15);
+    params.t1 = std::clamp(params.t1, 1, params.t2);
 
-    if (!can_form_party())
+    if (params.t1 != original_t1)
     {
-        std::cout << "Warning: Not enough players to form even one party (need 1 Tank, 1 Healer, 3 DPS)\n";
+        std::cout << "Note: t1 clamped from " << original_t1 << " to " << params.t1 << "\n";
     }
+    if (params.t2 != original_t2)
+    {
+        std::cout << "Note: t2 clamped from " << original_t2 << " to " << params.t2 << " (max: 15)\n";
+    }
+
+    if (options.seed_given)
+        params.seed = options.seed;
+    else if (!params.seed_given)
+        params.seed = std::random_device{}();
 
+    if (!options.samples_path.empty())
     {
-        std::scoped_lock print_lock(print_mutex);
-        std::cout << "=== Starting LFG Simulation ===\n"
-                  << pad("Instances:", 15) << g_instances << "\n"
-                  << pad("Players:", 15) << "Tanks = " << g_tanks
-                  << ", Healers = " << g_healers
-                  << ", DPS = " << g_dps << "\n"
-                  << pad("Clear time:", 15) << "[" << g_t1 << "," << g_t2 << "] seconds\n"
-                  << pad("Bonus mode:", 15)
-                  << (g_bonus_duration == 0 ? "Infinite" : std::to_string(g_bonus_duration) + " seconds")
-                  << "\n"
-                  << "================================\n\n";
+        if (options.sample_interval_ms < 1 || options.sample_capacity < 1)
+        {
+            std::cerr << "Error: --sample-interval-ms and --sample-capacity must be >= 1\n";
+            return 1;
+        }
+        params.sample_interval_ms = options.sample_interval_ms;
+        params.sample_capacity = options.sample_capacity;
     }
 
-    // Launch instance threads
-    std::vector<std::thread> instance_workers;
-    instance_workers.reserve(g_instances);
-    for (int i = 0; i < g_instances; ++i)
+    const PartyTemplate &party = params.party;
+    if (params.tanks < party.tanks || params.healers < party.healers || params.dps < party.dps)
     {
-        instance_workers.emplace_back(instance_loop, i);
+        std::cout << "Warning: Not enough players to form even one party (need "
+                  << party.tanks << " Tank, " << party.healers << " Healer, " << party.dps << " DPS)\n";
     }
 
-    // Launch player generator thread
-    std::thread player_gen(player_generator_thread);
+    print_header(params, options);
+
+    ModelPrediction model;
+    if (options.model || options.model_only)
+    {
+        model = predict(params, params.generator.value_or(WallClockProfile::generator));
+        print_prediction(model);
+        if (params.arrivals.active())
+            std::cout << "Note: the model assumes the flat arrival rate; the arrival curve is ignored\n";
+        if (options.model_only)
+            return 0;
+    }
 
-    // Wait for all instance threads to complete
-    for (auto &worker : instance_workers)
+    if (options.replicas > 0)
     {
-        worker.join();
+        int threads = options.threads > 0 ? options.threads
+                                           : static_cast<int>(std::max(1U, std::thread::hardware_concurrency()));
+        if (options.plan)
+            print_plan(plan_capacity(params, *options.plan, MAX_INSTANCES, options.replicas, threads), *options.plan,
+                       options.replicas);
+        else
+            print_confidence(run_replicas(params, options.replicas, threads));
+        return 0;
     }
 
-    // If bonus mode was never activated or infinite mode, end simulation
+    if (options.fork_at_s >= 0.0)
     {
-        std::scoped_lock lock(state_mutex);
-        if (!simulation_ended)
+        int threads = options.threads > 0 ? options.threads
+                                           : static_cast<int>(std::max(1U, std::thread::hardware_concurrency()));
+        std::vector<Branch> branches = options.branches;
+        branches.insert(branches.begin(), Branch{"baseline"});
+        std::vector<RunMetrics> runs = run_branches(params, options.fork_at_s, branches, threads);
+        if (runs.empty())
         {
-            simulation_ended = true;
-            player_available_cv.notify_all();
+            std::cerr << "Error: the simulation ended before --fork-at\n";
+            return 1;
         }
+        print_branches(branches, runs, options.fork_at_s);
+        return 0;
     }
 
-    // Wait for player generator to finish
-    player_gen.join();
+    SimulationResult result;
+    if (options.virtual_clock && options.verbose)
+    {
+        VerboseVirtualSimulation sim(params);
+        sim.run();
+        result = sim.result();
+    }
+    else if (options.virtual_clock)
+    {
+        SilentVirtualSimulation sim(params);
+        sim.run();
+        result = sim.result();
+    }
+    else if (options.driver == WallDriver::CentralMatcher)
+    {
+        result = run_wall_clock<CentralMatcherSimulation>(params, options);
+    }
+    else if (options.driver == WallDriver::Pipeline)
+    {
+        result = run_wall_clock<PipelineSimulation>(params, options);
+    }
+    else if (options.lock == StateLock::Ticket)
+    {
+        result = run_wall_clock<TicketLockSimulation>(params, options);
+    }
+    else if (options.lock == StateLock::Mcs)
+    {
+        result = run_wall_clock<McsLockSimulation>(params, options);
+    }
+    else
+    {
+        result = run_wall_clock<WallClockSimulation>(params, options);
+    }
 
-    // Final summary
-    int total_served = 0;
-    long long total_time = 0;
-    std::cout << "\n=== Simulation Summary ===\n";
-    for (int i = 0; i < g_instances; ++i)
+    print_summary(result);
+
+    if (!options.samples_path.empty())
     {
-        const Instance &inst = instances[i];
-        std::cout << "Instance " << i << ": Served " << inst.served
-                  << " parties, Total time " << inst.total_time << " seconds\n";
-        total_served += inst.served;
-        total_time += inst.total_time;
+        std::ofstream csv(options.samples_path);
+        if (!csv)
+        {
+            std::cerr << "Error: cannot write " << options.samples_path << "\n";
+            return 1;
+        }
+        write_samples_csv(csv, result.samples, params.instances);
+        std::cout << "Wrote " << result.samples.size() << " samples to " << options.samples_path;
+        if (result.samples_dropped > 0)
+            std::cout << " (" << result.samples_dropped << " oldest overwritten)";
+        std::cout << "\n";
     }
-    std::cout << "--------------------------\n"
-              << "Total parties served: " << total_served << "\n"
-              << "Total time spent: " << total_time << " seconds\n"
-              << "\nBonus players generated:\n"
-              << "  Tanks: " << g_bonus_tanks_added << "\n"
-              << "  Healers: " << g_bonus_healers_added << "\n"
-              << "  DPS: " << g_bonus_dps_added << "\n"
-              << "  Total: " << (g_bonus_tanks_added + g_bonus_healers_added + g_bonus_dps_added) << "\n"
-              << "\nRemaining players:\n"
-              << "  Tanks: " << g_tanks << "\n"
-              << "  Healers: " << g_healers << "\n"
-              << "  DPS: " << g_dps << "\n"
-              << "==========================\n";
+
+    if (options.model)
+        print_comparison(model, result);
 
     return 0;
 }
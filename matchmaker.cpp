@@ -0,0 +1,172 @@
+#include "matchmaker.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace
+{
+
+constexpr std::uint32_t MAX_ANCHORS = 64; // per region; bounds the search when the head is unmatchable
+
+} // namespace
+
+Matchmaker::Matchmaker(const MatchConfig &config)
+    : config_(config),
+      pools_(config.regions),
+      matches_(config.regions),
+      nearest_(config.regions)
+{
+    for (int r = 0; r < config_.regions; ++r)
+    {
+        for (int h = 0; h < config_.regions; ++h)
+        {
+            nearest_[r].push_back(h);
+        }
+        std::stable_sort(nearest_[r].begin(), nearest_[r].end(), [this, r](int a, int b)
+                         { return distance(r, a) < distance(r, b); });
+    }
+}
+
+auto Matchmaker::distance(int a, int b) const -> int
+{
+    int d = std::abs(a - b);
+    return std::min(d, config_.regions - d);
+}
+
+void Matchmaker::push(int role, const PlayerAttributes &attrs, SimTime arrival_ms)
+{
+    pools_[attrs.region][role].push(attrs, arrival_ms);
+}
+
+auto Matchmaker::queued(int role) const -> std::uint32_t
+{
+    std::uint32_t total = 0;
+    for (const auto &pool : pools_)
+    {
+        total += pool[role].live();
+    }
+    return total;
+}
+
+auto Matchmaker::any_ready() const -> bool
+{
+    return std::any_of(matches_.begin(), matches_.end(), [](const RegionMatch &m)
+                       { return m.ready; });
+}
+
+void Matchmaker::refresh(SimTime now)
+{
+    for (int region = 0; region < config_.regions; ++region)
+    {
+        match_region(region, now);
+    }
+}
+
+void Matchmaker::match_region(int region, SimTime now)
+{
+    matches_[region].ready = false;
+    for (int r = 0; r < ROLE_COUNT; ++r)
+    {
+        if (queued(r) < static_cast<std::uint32_t>(config_.party[r]))
+            return;
+    }
+
+    int anchor_role = 0;
+    while (anchor_role < ROLE_COUNT - 1 && config_.party[anchor_role] == 0)
+        ++anchor_role;
+
+    // Oldest anchors of the nearest regions first
+    for (int home : nearest_[region])
+    {
+        const PlayerStore &store = pools_[home][anchor_role];
+        for (std::uint32_t k = 0; k < MAX_ANCHORS; ++k)
+        {
+            std::uint32_t anchor = store.nth_live(k);
+            if (anchor == PlayerStore::npos)
+                break;
+            if (try_anchor(region, anchor_role, PlayerRef{home, anchor}, now))
+            {
+                matches_[region].ready = true;
+                return;
+            }
+        }
+    }
+}
+
+auto Matchmaker::try_anchor(int region, int anchor_role, PlayerRef anchor_ref, SimTime now) -> bool
+{
+    const PlayerStore &anchor_store = pools_[anchor_ref.home][anchor_role];
+    const PlayerAttributes &anchor = anchor_store.attributes(anchor_ref.index);
+    SimTime anchor_arrival = anchor_store.arrival(anchor_ref.index);
+
+    // Latency cap for this party, relaxed by how long the anchor has waited
+    bool capped = config_.max_latency_ms > 0;
+    long long cap = config_.max_latency_ms +
+                    static_cast<long long>(config_.relax_ms_per_s) * (now - anchor_arrival) / 1000;
+    if (capped && anchor.latency_ms + config_.region_penalty_ms * distance(anchor.region, region) > cap)
+        return false;
+
+    AttributeWindow window;
+    if (config_.rating_window > 0)
+    {
+        window.rating_lo = anchor.rating - config_.rating_window;
+        window.rating_hi = anchor.rating + config_.rating_window;
+    }
+
+    RegionMatch &match = matches_[region];
+    for (int r = 0; r < ROLE_COUNT; ++r)
+    {
+        match.members[r].clear();
+        auto remaining = static_cast<std::uint32_t>(config_.party[r]);
+        if (r == anchor_role && remaining > 0)
+        {
+            // The anchor fills its own seat; the rest of its role comes from the pools
+            match.members[r].push_back(anchor_ref);
+            --remaining;
+        }
+        for (int home : nearest_[region])
+        {
+            if (remaining == 0)
+                break;
+            if (capped)
+            {
+                // Regions are visited nearest first, so once the penalty alone
+                // exceeds the cap no later region can help either
+                long long home_cap = cap - static_cast<long long>(config_.region_penalty_ms) * distance(home, region);
+                if (home_cap < 0)
+                    break;
+                window.max_latency_ms = static_cast<std::int32_t>(
+                    std::min<long long>(home_cap, AttributeWindow{}.max_latency_ms));
+            }
+
+            // The anchor passes its own window, so ask for one more and skip it
+            bool skip_anchor = r == anchor_role && home == anchor_ref.home && config_.party[r] > 0;
+            std::uint32_t found = pools_[home][r].find(window, remaining + (skip_anchor ? 1 : 0), scratch_);
+            for (std::uint32_t i = 0; i < found && remaining > 0; ++i)
+            {
+                if (skip_anchor && scratch_[i] == anchor_ref.index)
+                    continue;
+                match.members[r].push_back(PlayerRef{home, scratch_[i]});
+                --remaining;
+            }
+        }
+        if (remaining > 0)
+            return false;
+    }
+    return true;
+}
+
+void Matchmaker::remove_members(int role, const std::vector<PlayerRef> &members)
+{
+    for (int home = 0; home < config_.regions; ++home)
+    {
+        scratch_.clear();
+        for (const PlayerRef &ref : members)
+        {
+            if (ref.home == home)
+                scratch_.push_back(ref.index);
+        }
+        if (!scratch_.empty())
+            pools_[home][role].remove(scratch_);
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "player_store.h"
+#include "policies.h"
+#include "roles.h"
+
+// Settings for attribute-aware matching
+struct MatchConfig
+{
+    int rating_window = 0;          // +/- rating around the anchor, 0 = any rating
+    int max_latency_ms = 0;         // latency cap at zero wait, 0 = no cap
+    int regions = 1;                // data centers; instance i lives in region i % regions
+    int region_penalty_ms = 80;     // extra latency per hop between neighbouring regions
+    int relax_ms_per_s = 0;         // cap grows by this much per second the anchor has waited
+    std::array<int, ROLE_COUNT> party{1, 1, 3};
+};
+
+// Attribute- and region-aware role pools. Players are queued per home region
+// and role; each instance region keeps its own precomputed next party, built
+// from the nearest regions first so low-latency groups are preferred. The
+// latency cap relaxes as the anchor player keeps waiting.
+class Matchmaker
+{
+public:
+    Matchmaker() = default;
+    explicit Matchmaker(const MatchConfig &config);
+
+    void push(int role, const PlayerAttributes &attrs, SimTime arrival_ms);
+
+    // Recompute the next party for every instance region
+    void refresh(SimTime now);
+
+    [[nodiscard]] auto ready(int region) const -> bool { return matches_[region].ready; }
+    [[nodiscard]] auto any_ready() const -> bool;
+
+    // Remove the party prepared for `region`. on_player(role, wait_ms, latency_ms)
+    // is called for every member. Call refresh() afterwards.
+    template <typename OnPlayer>
+    void take(int region, SimTime now, OnPlayer &&on_player)
+    {
+        RegionMatch &match = matches_[region];
+        for (int r = 0; r < ROLE_COUNT; ++r)
+        {
+            for (const PlayerRef &ref : match.members[r])
+            {
+                const PlayerStore &store = pools_[ref.home][r];
+                int latency = store.attributes(ref.index).latency_ms +
+                              config_.region_penalty_ms * distance(ref.home, region);
+                on_player(r, now - store.arrival(ref.index), latency);
+            }
+            remove_members(r, match.members[r]);
+        }
+        match.ready = false;
+    }
+
+    [[nodiscard]] auto queued(int role) const -> std::uint32_t;
+    [[nodiscard]] auto regions() const -> int { return config_.regions; }
+
+    // Ring distance between two regions
+    [[nodiscard]] auto distance(int a, int b) const -> int;
+
+private:
+    struct PlayerRef
+    {
+        int home;
+        std::uint32_t index;
+    };
+
+    struct RegionMatch
+    {
+        bool ready = false;
+        std::array<std::vector<PlayerRef>, ROLE_COUNT> members;
+    };
+
+    void match_region(int region, SimTime now);
+    void remove_members(int role, const std::vector<PlayerRef> &members);
+    auto try_anchor(int region, int anchor_role, PlayerRef anchor_ref, SimTime now) -> bool;
+
+    MatchConfig config_;
+    std::vector<std::array<PlayerStore, ROLE_COUNT>> pools_; // [home region][role]
+    std::vector<RegionMatch> matches_;                       // [instance region]
+    std::vector<std::vector<int>> nearest_;                  // [region] -> regions by distance
+    std::vector<std::uint32_t> scratch_;
+};
@@ -0,0 +1,241 @@
+#include "model.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include "format.h"
+
+namespace
+{
+
+// Probability that one generator check produces a wave. Mirrors roll_wave():
+// an integer k in [0, 100] is drawn and the wave fires when k / 100 < p.
+auto wave_probability(double p) -> double
+{
+    int hits = 0;
+    for (int k = 0; k <= 100; ++k)
+    {
+        if (static_cast<double>(k) / 100.0 < p)
+            ++hits;
+    }
+    return hits / 101.0;
+}
+
+// Erlang C: probability that an arrival finds all c servers busy, offered load a < c
+auto erlang_c(int c, double a) -> double
+{
+    double b = 1.0; // Erlang B, built up one server at a time
+    for (int k = 1; k <= c; ++k)
+    {
+        b = a * b / (k + a * b);
+    }
+    return c * b / (c - a * (1.0 - b));
+}
+
+auto role_counts(const SimulationParams &params) -> std::array<int, ROLE_COUNT>
+{
+    return {params.tanks, params.healers, params.dps};
+}
+
+auto party_counts(const PartyTemplate &party) -> std::array<int, ROLE_COUNT>
+{
+    return {party.tanks, party.healers, party.dps};
+}
+
+template <std::size_t N>
+void append_rate(FormatBuffer<N> &buf, double per_second)
+{
+    buf.template append_fixed<2>(per_second).append("/s");
+}
+
+} // namespace
+
+auto predict(const SimulationParams &params, const GeneratorConfig &generator) -> ModelPrediction
+{
+    ModelPrediction m;
+    const auto party = party_counts(params.party);
+    const auto initial = role_counts(params);
+    const std::array<double, ROLE_COUNT> mean_wave = {
+        (generator.min_tanks_per_wave + generator.max_tanks_per_wave) / 2.0,
+        (generator.min_healers_per_wave + generator.max_healers_per_wave) / 2.0,
+        (generator.min_dps_per_wave + generator.max_dps_per_wave) / 2.0,
+    };
+
+    // Discrete uniform service time on [t1, t2] seconds
+    double span = params.t2 - params.t1 + 1;
+    m.mean_service_s = (params.t1 + params.t2) / 2.0;
+    m.service_cv2 = ((span * span - 1.0) / 12.0) / (m.mean_service_s * m.mean_service_s);
+
+    // Role-coupled arrivals: a party forms only as fast as its scarcest role arrives
+    double interval_s = generator.check_interval_ms / 1000.0;
+    double p_wave = wave_probability(generator.generation_probability);
+    m.party_rate = std::numeric_limits<double>::infinity();
+    m.initial_parties = std::numeric_limits<int>::max();
+    for (int r = 0; r < ROLE_COUNT; ++r)
+    {
+        m.role_rate[r] = p_wave * mean_wave[r] / interval_s;
+        if (party[r] == 0)
+            continue;
+        if (m.role_rate[r] / party[r] < m.party_rate)
+        {
+            m.party_rate = m.role_rate[r] / party[r];
+            m.bottleneck_role = static_cast<Role>(r);
+        }
+        m.initial_parties = std::min(m.initial_parties, initial[r] / party[r]);
+    }
+
+    // M/G/c with c = instances
+    int c = params.instances;
+    m.capacity = c / m.mean_service_s;
+    m.throughput = std::min(m.party_rate, m.capacity);
+    m.instance_limited = m.party_rate >= m.capacity;
+    double offered = m.party_rate * m.mean_service_s;
+    m.utilization = std::min(1.0, offered / c);
+    if (offered < c)
+    {
+        m.wait_probability = erlang_c(c, offered);
+        m.mean_wait_s = m.wait_probability / (m.capacity - m.party_rate) * (1.0 + m.service_cv2) / 2.0;
+    }
+    else
+    {
+        m.wait_probability = 1.0;
+        m.mean_wait_s = std::numeric_limits<double>::infinity();
+    }
+
+    // Bonus generation starts once an instance frees up and finds no initial party left
+    m.initial_drain_s = std::max(0, m.initial_parties - c + 1) * m.mean_service_s / c;
+
+    if (params.bonus_duration > 0)
+    {
+        m.finite = true;
+        double ticks = std::ceil(params.bonus_duration * 1000.0 / generator.check_interval_ms);
+        double by_players = std::numeric_limits<double>::infinity();
+        for (int r = 0; r < ROLE_COUNT; ++r)
+        {
+            m.bonus_players[r] = ticks * p_wave * mean_wave[r];
+            if (party[r] > 0)
+                by_players = std::min(by_players, (initial[r] + m.bonus_players[r]) / party[r]);
+        }
+
+        // Instances keep draining formable parties after generation stops, so
+        // players bound the total and capacity only stretches the run
+        m.parties_served = std::floor(by_players);
+        double generation_end = m.initial_drain_s + params.bonus_duration;
+        m.horizon_s = std::max(generation_end, m.parties_served / m.capacity) + m.mean_service_s;
+
+        for (int r = 0; r < ROLE_COUNT; ++r)
+        {
+            m.remaining_players[r] = initial[r] + m.bonus_players[r] - party[r] * m.parties_served;
+        }
+    }
+
+    return m;
+}
+
+void print_prediction(const ModelPrediction &model)
+{
+    FormatBuffer<2048> out;
+    out.append("\n=== Queueing Model (M/G/c) ===\n")
+        .append_field<20>("Service time:")
+        .append("mean ").append_fixed<2>(model.mean_service_s)
+        .append("s, cv^2 ").append_fixed<2>(model.service_cv2).append('\n')
+        .append_field<20>("Arrival rates:");
+    for (int r = 0; r < ROLE_COUNT; ++r)
+    {
+        out.append(r == 0 ? "" : ", ").append(role_to_string(static_cast<Role>(r))).append(' ');
+        append_rate(out, model.role_rate[r]);
+    }
+    out.append('\n').append_field<20>("Party rate:");
+    append_rate(out, model.party_rate);
+    out.append(" (bottleneck role: ").append(role_to_string(model.bottleneck_role)).append(")\n")
+        .append_field<20>("Capacity:");
+    append_rate(out, model.capacity);
+    out.append('\n').append_field<20>("Throughput:");
+    append_rate(out, model.throughput);
+    out.append(model.instance_limited ? " (instance-limited)\n" : " (role-limited)\n")
+        .append_field<20>("Utilization:").append_fixed<1>(model.utilization * 100.0).append("%\n")
+        .append_field<20>("P(wait):").append_fixed<1>(model.wait_probability * 100.0).append("%\n")
+        .append_field<20>("Mean party wait:");
+    if (std::isfinite(model.mean_wait_s))
+        out.append_fixed<2>(model.mean_wait_s).append("s\n");
+    else
+        out.append("unbounded (queue grows)\n");
+    out.append_field<20>("Initial parties:").append(model.initial_parties)
+        .append(" (bonus starts after ~").append_fixed<1>(model.initial_drain_s).append("s)\n");
+
+    if (model.finite)
+    {
+        out.append_field<20>("Parties served:").append_fixed<0>(model.parties_served).append('\n');
+        for (int r = 0; r < ROLE_COUNT; ++r)
+        {
+            out.append_field<20>("Remaining ", role_to_string(static_cast<Role>(r)), ':')
+                .append_fixed<0>(std::max(0.0, model.remaining_players[r])).append('\n');
+        }
+    }
+    out.append("==============================\n");
+    std::cout << out;
+}
+
+void print_comparison(const ModelPrediction &model, const SimulationResult &result)
+{
+    if (!model.finite)
+        return;
+
+    int served = 0;
+    long long busy_s = 0;
+    for (const Instance &inst : result.instances)
+    {
+        served += inst.served;
+        busy_s += inst.total_time;
+    }
+    const std::array<int, ROLE_COUNT> bonus = {result.bonus_tanks_added, result.bonus_healers_added,
+                                               result.bonus_dps_added};
+    const std::array<int, ROLE_COUNT> remaining = {result.remaining_tanks, result.remaining_healers,
+                                                   result.remaining_dps};
+    double elapsed_s = result.elapsed_ms / 1000.0;
+    double n = static_cast<double>(result.instances.size());
+    double model_util = model.parties_served * model.mean_service_s / (n * model.horizon_s);
+    double sim_util = elapsed_s > 0.0 ? busy_s / (n * elapsed_s) : 0.0;
+
+    FormatBuffer<2048> out;
+    out.append("\n=== Model vs Simulation ===\n")
+        .append_field<22>("Metric").append_field<12>("Model").append("Simulated\n")
+        .append_field<22>("Parties served").append_field<12>(static_cast<long long>(model.parties_served))
+        .append(served).append('\n');
+    for (int r = 0; r < ROLE_COUNT; ++r)
+    {
+        out.append_field<22>("Bonus ", role_to_string(static_cast<Role>(r)))
+            .append_field<12>(static_cast<long long>(std::lround(model.bonus_players[r])))
+            .append(bonus[r]).append('\n');
+    }
+    for (int r = 0; r < ROLE_COUNT; ++r)
+    {
+        out.append_field<22>("Remaining ", role_to_string(static_cast<Role>(r)))
+            .append_field<12>(static_cast<long long>(std::lround(std::max(0.0, model.remaining_players[r]))))
+            .append(remaining[r]).append('\n');
+    }
+    out.append_field<22>("Elapsed (s)").append_field<12>(static_cast<long long>(std::lround(model.horizon_s)))
+        .append_fixed<1>(elapsed_s).append('\n');
+
+    FormatBuffer<16> model_pct;
+    model_pct.append_fixed<1>(model_util * 100.0).append('%');
+    out.append_field<22>("Utilization").append_field<12>(model_pct.view())
+        .append_fixed<1>(sim_util * 100.0).append("%\n");
+
+    // A formed party's wait for an instance once bonus players feed the
+    // queue, by Little's law on the simulated party-seconds waiting
+    const BottleneckStats &stats = result.bottleneck;
+    FormatBuffer<16> model_wait;
+    if (std::isfinite(model.mean_wait_s))
+        model_wait.append_fixed<2>(model.mean_wait_s);
+    else
+        model_wait.append("unbounded");
+    out.append_field<22>("Mean wait (s)").append_field<12>(model_wait.view());
+    if (stats.bonus_parties > 0)
+        out.append_fixed<2>(stats.bonus_waiting_party_s / static_cast<double>(stats.bonus_parties)).append('\n');
+    else
+        out.append("-\n");
+    out.append("===========================\n");
+    std::cout << out;
+}
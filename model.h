@@ -0,0 +1,47 @@
+#pragma once
+#include <array>
+#include "simulation.h"
+
+// Closed-form queueing estimate for one run.
+//
+// Instances are the c servers of an M/G/c queue whose "customers" are parties.
+// Parties arrive at the rate the scarcest role can fill them (role-coupled
+// arrivals); service time is uniform on [t1, t2]. Waiting time uses the
+// Allen-Cunneen approximation with Poisson party arrivals.
+struct ModelPrediction
+{
+    // Service
+    double mean_service_s = 0.0;
+    double service_cv2 = 0.0; // squared coefficient of variation
+
+    // Arrivals during bonus generation
+    std::array<double, ROLE_COUNT> role_rate{}; // players per second
+    double party_rate = 0.0;                    // parties per second the arrivals can fill
+    Role bottleneck_role = Role::Tank;
+
+    // Instance pool
+    double capacity = 0.0;    // parties per second with every instance busy
+    double throughput = 0.0;  // min(party_rate, capacity)
+    double utilization = 0.0; // offered load / instances
+    bool instance_limited = false;
+    double wait_probability = 0.0; // Erlang C
+    double mean_wait_s = 0.0;      // formed party waiting for an instance; infinite if unstable
+
+    // Initial burst
+    int initial_parties = 0;
+    double initial_drain_s = 0.0;
+
+    // Finite bonus window only (bonus_duration > 0)
+    bool finite = false;
+    double horizon_s = 0.0;
+    double parties_served = 0.0;
+    std::array<double, ROLE_COUNT> bonus_players{};
+    std::array<double, ROLE_COUNT> remaining_players{};
+};
+
+auto predict(const SimulationParams &params, const GeneratorConfig &generator) -> ModelPrediction;
+
+void print_prediction(const ModelPrediction &model);
+
+// Side-by-side table of predicted and simulated totals
+void print_comparison(const ModelPrediction &model, const SimulationResult &result);
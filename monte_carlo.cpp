@@ -0,0 +1,295 @@
+#include "monte_carlo.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include "format.h"
+#include "profiles.h"
+#include "utils.h"
+
+auto merged_waits(const SimulationResult &result, int role) -> QuantileSketch
+{
+    QuantileSketch merged;
+    for (const InstanceDistributions &d : result.distributions)
+    {
+        for (int r = 0; r < ROLE_COUNT; ++r)
+        {
+            if (role < 0 || r == role)
+                merged.merge(d.waits_s[r]);
+        }
+    }
+    return merged;
+}
+
+auto merged_runs(const SimulationResult &result) -> QuantileSketch
+{
+    QuantileSketch merged;
+    for (const InstanceDistributions &d : result.distributions)
+        merged.merge(d.runs_s);
+    return merged;
+}
+
+auto measure(const SimulationResult &result) -> RunMetrics
+{
+    return measure_window(SimulationResult{}, result);
+}
+
+auto measure_window(const SimulationResult &from, const SimulationResult &to) -> RunMetrics
+{
+    RunMetrics m;
+    long long busy_s = 0;
+    for (std::size_t i = 0; i < to.instances.size(); ++i)
+    {
+        m.parties += to.instances[i].served;
+        busy_s += to.instances[i].total_time;
+        if (i < from.instances.size())
+        {
+            m.parties -= from.instances[i].served;
+            busy_s -= from.instances[i].total_time;
+        }
+    }
+
+    double elapsed_s = static_cast<double>(to.elapsed_ms - from.elapsed_ms) / 1000.0;
+    if (elapsed_s > 0.0)
+    {
+        m.throughput_per_min = m.parties * 60.0 / elapsed_s;
+        m.utilization = static_cast<double>(busy_s) / (std::max(to.online_instances, 1) * elapsed_s);
+    }
+
+    // Sketches cannot be subtracted: callers that want only the window's
+    // waits reset them at its start (see run_branches)
+    QuantileSketch waits = merged_waits(to);
+    m.wait_mean_s = waits.mean();
+    m.wait_p50_s = waits.quantile(0.50);
+    m.wait_p95_s = waits.quantile(0.95);
+    m.wait_p99_s = waits.quantile(0.99);
+    return m;
+}
+
+namespace
+{
+
+// Run job(0) .. job(count - 1) on `threads` workers pulling from a shared counter
+template <typename Job>
+void run_jobs(int count, int threads, Job &&job)
+{
+    std::atomic<int> next = 0;
+    auto worker = [&]()
+    {
+        for (int i = next.fetch_add(1); i < count; i = next.fetch_add(1))
+        {
+            job(i);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads);
+    for (int t = 0; t < threads; ++t)
+    {
+        pool.emplace_back(worker);
+    }
+    for (auto &th : pool)
+    {
+        th.join();
+    }
+}
+
+auto run_replica(const SimulationParams &params, int index) -> RunMetrics
+{
+    SimulationParams replica = params;
+    replica.seed = mix_seed(params.seed, static_cast<std::uint64_t>(index));
+    SilentVirtualSimulation sim(replica);
+    sim.run();
+    return measure(sim.result());
+}
+
+} // namespace
+
+auto run_replicas(const SimulationParams &params, int replicas, int threads) -> std::vector<RunMetrics>
+{
+    std::vector<RunMetrics> runs(replicas);
+    run_jobs(replicas, threads, [&](int i) { runs[i] = run_replica(params, i); });
+    return runs;
+}
+
+auto plan_capacity(const SimulationParams &params, const WaitSlo &slo, int max_instances, int replicas, int threads)
+    -> CapacityPlan
+{
+    CapacityPlan plan;
+    // Invariant: sizes <= lo are known to miss the SLO, sizes >= hi are known
+    // to meet it (hi = max_instances + 1 means "not found yet")
+    int lo = 0;
+    int hi = max_instances + 1;
+    int probes_per_round = std::max(1, threads / std::max(1, replicas));
+
+    while (hi - lo > 1)
+    {
+        // Evenly spaced probes strictly inside (lo, hi); with one probe, the midpoint
+        int gap = hi - lo - 1;
+        int probes = std::min(probes_per_round, gap);
+        std::vector<int> sizes(probes);
+        for (int k = 0; k < probes; ++k)
+            sizes[k] = lo + static_cast<int>(static_cast<long long>(k + 1) * (gap + 1) / (probes + 1));
+
+        std::vector<RunMetrics> runs(static_cast<std::size_t>(probes) * replicas);
+        run_jobs(static_cast<int>(runs.size()), threads, [&](int job)
+                 {
+                     SimulationParams sized = params;
+                     sized.instances = sizes[job / replicas];
+                     sized.regions = std::min(sized.regions, sized.instances);
+                     runs[job] = run_replica(sized, job % replicas);
+                 });
+
+        for (int k = 0; k < probes; ++k)
+        {
+            std::vector<double> values;
+            values.reserve(replicas);
+            for (int r = 0; r < replicas; ++r)
+                values.push_back(runs[static_cast<std::size_t>(k) * replicas + r].*slo.metric);
+
+            PlanStep step{sizes[k], confidence_95(values), false};
+            step.meets = step.wait.mean <= slo.limit_s;
+            plan.steps.push_back(step);
+        }
+        // Probes are ascending; keep the tightest bracket they give
+        for (int k = 0; k < probes; ++k)
+        {
+            if (plan.steps[plan.steps.size() - probes + k].meets)
+            {
+                hi = std::min(hi, sizes[k]);
+                break;
+            }
+            lo = sizes[k];
+        }
+        ++plan.rounds;
+    }
+
+    if (hi <= max_instances)
+        plan.instances = hi;
+    std::sort(plan.steps.begin(), plan.steps.end(), [](const PlanStep &a, const PlanStep &b)
+              { return a.instances < b.instances; });
+    return plan;
+}
+
+void print_plan(const CapacityPlan &plan, const WaitSlo &slo, int replicas)
+{
+    FormatBuffer<4096> out;
+    out.append("\n=== Capacity plan: ").append(slo.label).append(" wait <= ").append_fixed<1>(slo.limit_s)
+        .append(" s (").append(replicas).append(" replicas per size, ").append(plan.rounds).append(" rounds) ===\n")
+        .append_field<12>("Instances").append_field<16>(slo.label, " wait (s)").append_field<12>("+/-")
+        .append("SLO\n");
+    for (const PlanStep &step : plan.steps)
+    {
+        FormatBuffer<16> wait_s, hw_s;
+        wait_s.append_fixed<1>(step.wait.mean);
+        hw_s.append_fixed<1>(step.wait.half_width);
+        out.append_field<12>(step.instances).append_field<16>(wait_s.view()).append_field<12>(hw_s.view())
+            .append(step.meets ? "met" : "missed").append('\n');
+    }
+    if (plan.instances > 0)
+        out.append("Smallest pool meeting the SLO: ").append(plan.instances).append(" instances\n");
+    else
+        out.append("No pool up to the largest size evaluated meets the SLO\n");
+
+    // Waits that no longer fall with more instances are set by role arrivals
+    if (plan.instances == 0 && plan.steps.size() > 1)
+    {
+        const ConfidenceInterval &smallest = plan.steps.front().wait;
+        const ConfidenceInterval &largest = plan.steps.back().wait;
+        if (smallest.mean - largest.mean <= smallest.half_width + largest.half_width)
+            out.append("Waits do not fall with pool size: role arrivals, not instances, are the bottleneck\n");
+    }
+    out.append("==============================================\n");
+    std::cout << out;
+}
+
+void print_confidence(const std::vector<RunMetrics> &runs)
+{
+    struct Column
+    {
+        const char *label;
+        double RunMetrics::*field;
+    };
+    constexpr Column columns[] = {
+        {"Parties served", &RunMetrics::parties},
+        {"Throughput (/min)", &RunMetrics::throughput_per_min},
+        {"Utilization", &RunMetrics::utilization},
+        {"Wait mean (s)", &RunMetrics::wait_mean_s},
+        {"Wait p50 (s)", &RunMetrics::wait_p50_s},
+        {"Wait p95 (s)", &RunMetrics::wait_p95_s},
+        {"Wait p99 (s)", &RunMetrics::wait_p99_s},
+    };
+
+    FormatBuffer<2048> out;
+    out.append("\n=== Monte Carlo (").append(runs.size()).append(" replicas, 95% CI) ===\n")
+        .append_field<20>("Metric").append_field<12>("Mean").append_field<12>("+/-")
+        .append_field<12>("Min").append("Max\n");
+    for (const Column &col : columns)
+    {
+        std::vector<double> values;
+        values.reserve(runs.size());
+        for (const RunMetrics &run : runs)
+        {
+            values.push_back(run.*col.field);
+        }
+        ConfidenceInterval ci = confidence_95(values);
+
+        FormatBuffer<16> mean_s, hw_s, min_s;
+        mean_s.append_fixed<3>(ci.mean);
+        hw_s.append_fixed<3>(ci.half_width);
+        min_s.append_fixed<3>(ci.min);
+        out.append_field<20>(col.label).append_field<12>(mean_s.view()).append_field<12>(hw_s.view())
+            .append_field<12>(min_s.view()).append_fixed<3>(ci.max).append('\n');
+    }
+    out.append("==============================================\n");
+    std::cout << out;
+}
+
+auto run_branches(const SimulationParams &params, double warmup_s, const std::vector<Branch> &branches, int threads)
+    -> std::vector<RunMetrics>
+{
+    SilentVirtualSimulation warm(params);
+    warm.run_until(static_cast<SimTime>(warmup_s * 1000.0));
+    if (warm.ended())
+        return {};
+    const SimulationResult fork_point = warm.result();
+    warm.reset_distributions();
+
+    std::vector<RunMetrics> runs(branches.size());
+    run_jobs(static_cast<int>(branches.size()), threads, [&](int i)
+             {
+                 SilentVirtualSimulation branch = warm; // the fork: a plain in-memory copy
+                 if (branches[i].instances > 0)
+                     branch.resize_pool(branches[i].instances);
+                 if (branches[i].arrival_rate != 1.0)
+                     branch.scale_arrivals(branches[i].arrival_rate);
+                 branch.run();
+                 runs[i] = measure_window(fork_point, branch.result());
+             });
+    return runs;
+}
+
+void print_branches(const std::vector<Branch> &branches, const std::vector<RunMetrics> &runs, double warmup_s)
+{
+    FormatBuffer<4096> out;
+    out.append("\n=== What-if branches forked at t=").append_fixed<0>(warmup_s).append(" s ===\n")
+        .append_field<24>("Branch").append_field<10>("Parties").append_field<12>("Per min")
+        .append_field<8>("Util").append_field<12>("Wait mean").append_field<10>("p95").append("p99\n");
+    for (std::size_t i = 0; i < branches.size(); ++i)
+    {
+        const RunMetrics &m = runs[i];
+        FormatBuffer<16> parties, per_min, util, wait_mean, p95;
+        parties.append_fixed<0>(m.parties);
+        per_min.append_fixed<2>(m.throughput_per_min);
+        util.append_fixed<2>(m.utilization);
+        wait_mean.append_fixed<1>(m.wait_mean_s);
+        p95.append_fixed<1>(m.wait_p95_s);
+        out.append_field<24>(branches[i].label).append_field<10>(parties.view()).append_field<12>(per_min.view())
+            .append_field<8>(util.view()).append_field<12>(wait_mean.view()).append_field<10>(p95.view())
+            .append_fixed<1>(m.wait_p99_s).append('\n');
+    }
+    out.append("Metrics cover the time after the fork only.\n")
+        .append("==============================================\n");
+    std::cout << out;
+}
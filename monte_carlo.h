@@ -0,0 +1,88 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "simulation.h"
+#include "stats.h"
+
+// Headline numbers from one run
+struct RunMetrics
+{
+    double parties = 0.0;
+    double throughput_per_min = 0.0; // parties per simulated minute
+    double utilization = 0.0;        // busy instance-time / (instances * elapsed)
+    double wait_mean_s = 0.0;        // over every matched player
+    double wait_p50_s = 0.0;
+    double wait_p95_s = 0.0;
+    double wait_p99_s = 0.0;
+};
+
+// Wait distribution of one role (-1 = every role) or of dungeon run times,
+// merged over the per-instance sketches
+auto merged_waits(const SimulationResult &result, int role = -1) -> QuantileSketch;
+auto merged_runs(const SimulationResult &result) -> QuantileSketch;
+
+auto measure(const SimulationResult &result) -> RunMetrics;
+
+// Metrics of the stretch of one run between two of its results; the wait
+// percentiles come from `to` alone
+auto measure_window(const SimulationResult &from, const SimulationResult &to) -> RunMetrics;
+
+// Run `replicas` independent virtual-clock simulations of `params` on
+// `threads` worker threads. Replica i is seeded from (params.seed, i), so
+// the set of results does not depend on the thread count.
+auto run_replicas(const SimulationParams &params, int replicas, int threads) -> std::vector<RunMetrics>;
+
+// Mean and 95% confidence interval of every metric across replicas
+void print_confidence(const std::vector<RunMetrics> &runs);
+
+// Wait-time service level objective: `metric` of player wait <= limit_s
+struct WaitSlo
+{
+    double RunMetrics::*metric = &RunMetrics::wait_p95_s;
+    const char *label = "p95";
+    double limit_s = 60.0;
+};
+
+// One pool size the planner evaluated
+struct PlanStep
+{
+    int instances = 0;
+    ConfidenceInterval wait; // the SLO metric across replicas
+    bool meets = false;      // mean meets the SLO
+};
+
+struct CapacityPlan
+{
+    int instances = 0;            // smallest pool meeting the SLO, 0 = none up to max_instances
+    std::vector<PlanStep> steps;  // every size evaluated, by instance count
+    int rounds = 0;
+};
+
+// Smallest instance count in [1, max_instances] whose mean SLO metric over
+// `replicas` virtual-clock runs meets `slo`, assuming waits fall as the pool
+// grows. Each round probes several sizes at once so that all `threads` stay
+// busy (plain bisection when threads <= replicas). Every size runs the same
+// replica seeds, so durations and arrivals are common random numbers and
+// neighbouring sizes are compared on identical traffic.
+auto plan_capacity(const SimulationParams &params, const WaitSlo &slo, int max_instances, int replicas, int threads)
+    -> CapacityPlan;
+
+void print_plan(const CapacityPlan &plan, const WaitSlo &slo, int replicas);
+
+// One what-if branch: changes applied to the warm state before it resumes
+struct Branch
+{
+    std::string label;
+    int instances = 0;         // 0 = keep the warm pool
+    double arrival_rate = 1.0; // factor on every role's generator waves
+};
+
+// Run `params` on the virtual clock to warmup_s once, then clone that warm
+// state in memory for every branch, apply the branch's changes and run the
+// clones to the end on `threads` workers. The clones share the RNG streams,
+// so branches differ only by their changes. Metrics cover the time after
+// the fork. Returns nothing if the run ended during warm-up.
+auto run_branches(const SimulationParams &params, double warmup_s, const std::vector<Branch> &branches, int threads)
+    -> std::vector<RunMetrics>;
+
+void print_branches(const std::vector<Branch> &branches, const std::vector<RunMetrics> &runs, double warmup_s);
@@ -0,0 +1,104 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+// Bounded lock-free multi-producer / single-consumer queue (Vyukov's ring
+// with a sequence number per cell). All cells are allocated up front.
+// Producers claim a cell with one CAS on the tail; the single consumer never
+// contends with anyone. pop() sleeps on a futex-backed doorbell when empty.
+template <typename T>
+class MpscQueue
+{
+public:
+    // Capacity is rounded up to a power of two
+    explicit MpscQueue(std::size_t capacity)
+    {
+        std::size_t size = 2;
+        while (size < capacity)
+            size <<= 1;
+        mask_ = size - 1;
+        cells_ = std::make_unique<Cell[]>(size);
+        for (std::size_t i = 0; i < size; ++i)
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    // Any thread. Returns false if the queue is full.
+    auto try_push(const T &value) -> bool
+    {
+        std::size_t pos = tail_.load(std::memory_order_relaxed);
+        Cell *cell;
+        while (true)
+        {
+            cell = &cells_[pos & mask_];
+            std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+            if (diff == 0)
+            {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = value;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Any thread. Yields while the queue is full, then wakes the consumer.
+    void push(const T &value)
+    {
+        while (!try_push(value))
+            std::this_thread::yield();
+        doorbell_.fetch_add(1, std::memory_order_release);
+        doorbell_.notify_one();
+    }
+
+    // Consumer thread only
+    auto try_pop(T &out) -> bool
+    {
+        Cell &cell = cells_[head_ & mask_];
+        if (cell.sequence.load(std::memory_order_acquire) != head_ + 1)
+            return false;
+        out = cell.value;
+        cell.sequence.store(head_ + mask_ + 1, std::memory_order_release);
+        ++head_;
+        return true;
+    }
+
+    // Consumer thread only; blocks until a value arrives
+    void pop(T &out)
+    {
+        while (!try_pop(out))
+        {
+            // Read the doorbell, then re-check: a push that lands in between
+            // has already rung it, so the wait returns immediately
+            std::uint32_t rung = doorbell_.load(std::memory_order_acquire);
+            if (try_pop(out))
+                return;
+            doorbell_.wait(rung, std::memory_order_acquire);
+        }
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<std::size_t> sequence{0};
+        T value{};
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    std::size_t mask_ = 0;
+    alignas(64) std::atomic<std::size_t> tail_{0};
+    alignas(64) std::size_t head_ = 0;
+    alignas(64) std::atomic<std::uint32_t> doorbell_{0};
+};
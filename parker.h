@@ -0,0 +1,95 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// Tell the core we are spinning: frees pipeline resources for the sibling
+// hyperthread and avoids a memory-order flush when the spin ends
+inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// Wake-up slot owned by one waiting thread, in effect a binary semaphore.
+// park() first spins, because a wake-up often follows within microseconds,
+// and only then sleeps on a futex. unpark() makes the wake syscall only if
+// the owner is actually asleep. An unpark() that comes first is remembered,
+// so a thread can register itself as waiting under a lock, drop the lock
+// and park without missing a wake-up.
+class alignas(64) Parker
+{
+public:
+    // Spin rounds worth trying: none on a single core, where spinning only
+    // delays the thread that would wake us
+    [[nodiscard]] static auto default_spins() -> int
+    {
+        return std::thread::hardware_concurrency() > 1 ? 2048 : 0;
+    }
+
+    // Block until unparked. Returns true if the thread had to sleep.
+    auto park(int spins) -> bool
+    {
+        for (int i = 0; i < spins; ++i)
+        {
+            if (state_.load(std::memory_order_relaxed) == NOTIFIED)
+            {
+                std::int32_t expected = NOTIFIED;
+                if (state_.compare_exchange_strong(expected, EMPTY, std::memory_order_acquire))
+                    return false;
+            }
+            cpu_relax();
+        }
+
+        // EMPTY -> PARKED, or consume a NOTIFIED that arrived meanwhile
+        if (state_.fetch_sub(1, std::memory_order_acquire) == NOTIFIED)
+            return false;
+        while (true)
+        {
+            sleep_while_parked();
+            std::int32_t expected = NOTIFIED;
+            if (state_.compare_exchange_strong(expected, EMPTY, std::memory_order_acquire))
+                return true;
+        }
+    }
+
+    void unpark()
+    {
+        if (state_.exchange(NOTIFIED, std::memory_order_release) == PARKED)
+            wake();
+    }
+
+private:
+    static constexpr std::int32_t PARKED = -1;
+    static constexpr std::int32_t EMPTY = 0;
+    static constexpr std::int32_t NOTIFIED = 1;
+
+#ifdef __linux__
+    // std::atomic<int32_t> is a plain int32_t in memory, so the futex can watch it
+    auto word() -> std::uint32_t * { return reinterpret_cast<std::uint32_t *>(&state_); }
+
+    // Returns at once if the state already left PARKED; spurious wake-ups are
+    // handled by the caller's re-check
+    void sleep_while_parked()
+    {
+        syscall(SYS_futex, word(), FUTEX_WAIT_PRIVATE, static_cast<std::uint32_t>(PARKED), nullptr, nullptr, 0);
+    }
+    void wake() { syscall(SYS_futex, word(), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0); }
+#else
+    void sleep_while_parked() { state_.wait(PARKED, std::memory_order_acquire); }
+    void wake() { state_.notify_one(); }
+#endif
+
+    std::atomic<std::int32_t> state_{EMPTY};
+};
@@ -0,0 +1,78 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+// Philox4x32-10 (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3").
+// A keyed bijection on 128-bit counters: the output depends only on
+// (counter, key), so any draw can be computed independently of every other
+// one. Loops over consecutive counters have no carried state and vectorize.
+
+using PhiloxCounter = std::array<std::uint32_t, 4>;
+using PhiloxKey = std::array<std::uint32_t, 2>;
+
+constexpr auto philox4x32(PhiloxCounter ctr, PhiloxKey key) -> PhiloxCounter
+{
+    constexpr std::uint32_t M0 = 0xD2511F53;
+    constexpr std::uint32_t M1 = 0xCD9E8D57;
+    constexpr std::uint32_t W0 = 0x9E3779B9; // golden ratio
+    constexpr std::uint32_t W1 = 0xBB67AE85; // sqrt(3) - 1
+
+    for (int round = 0; round < 10; ++round)
+    {
+        std::uint64_t p0 = std::uint64_t{M0} * ctr[0];
+        std::uint64_t p1 = std::uint64_t{M1} * ctr[2];
+        ctr = {static_cast<std::uint32_t>(p1 >> 32) ^ ctr[1] ^ key[0], static_cast<std::uint32_t>(p1),
+               static_cast<std::uint32_t>(p0 >> 32) ^ ctr[3] ^ key[1], static_cast<std::uint32_t>(p0)};
+        key[0] += W0;
+        key[1] += W1;
+    }
+    return ctr;
+}
+
+constexpr auto philox_key(std::uint64_t seed) -> PhiloxKey
+{
+    return {static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)};
+}
+
+// Integer in [lo, hi] from one block by multiply-shift (Lemire) on the first
+// word. Branch-free, so batches vectorize; the bias is below range / 2^32,
+// i.e. under 4e-9 for dungeon durations.
+constexpr auto bounded_from_block(const PhiloxCounter &block, int lo, int hi) -> int
+{
+    auto range = static_cast<std::uint64_t>(static_cast<std::uint32_t>(hi - lo)) + 1;
+    return lo + static_cast<int>((std::uint64_t{block[0]} * range) >> 32);
+}
+
+// Streams keep draws with different purposes from ever sharing a counter
+enum class PhiloxStream : std::uint32_t
+{
+    Duration = 0,  // counter = (instance id, run index)
+    General = 1,   // counter = (draw number)
+    Generator = 2  // counter = (generator thread, draw number)
+};
+
+// The draw identified by (seed, stream, a, b), as an integer in [lo, hi]
+constexpr auto philox_uniform(std::uint64_t seed, PhiloxStream stream, std::uint32_t a, std::uint64_t b,
+                              int lo, int hi) -> int
+{
+    PhiloxCounter ctr{a, static_cast<std::uint32_t>(b), static_cast<std::uint32_t>(b >> 32),
+                      static_cast<std::uint32_t>(stream)};
+    return bounded_from_block(philox4x32(ctr, philox_key(seed)), lo, hi);
+}
+
+// Durations of runs [first_run, first_run + count) of one instance. Each
+// iteration is independent, so the compiler vectorizes the loop.
+inline void philox_durations(std::uint64_t seed, std::uint32_t instance_id, std::uint64_t first_run,
+                             std::uint32_t count, int lo, int hi, int *out)
+{
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        out[i] = philox_uniform(seed, PhiloxStream::Duration, instance_id, first_run + i, lo, hi);
+    }
+}
+
+// Known-answer vectors from the Random123 distribution
+static_assert(philox4x32({0, 0, 0, 0}, {0, 0}) ==
+              PhiloxCounter{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8});
+static_assert(philox4x32({0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}, {0xffffffff, 0xffffffff}) ==
+              PhiloxCounter{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd});
@@ -0,0 +1,149 @@
+#include "player_store.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PSET2_X86 1
+#endif
+
+auto filter_window_scalar(const std::int32_t *rating, const std::int32_t *latency,
+                          std::uint32_t begin, std::uint32_t end, const AttributeWindow &window,
+                          std::uint32_t *out, std::uint32_t limit) -> std::uint32_t
+{
+    std::uint32_t n = 0;
+    for (std::uint32_t i = begin; i < end && n < limit; ++i)
+    {
+        if (rating[i] >= window.rating_lo && rating[i] <= window.rating_hi &&
+            latency[i] <= window.max_latency_ms)
+        {
+            out[n++] = i;
+        }
+    }
+    return n;
+}
+
+#ifdef PSET2_X86
+
+__attribute__((target("avx2"))) auto filter_window_avx2(const std::int32_t *rating, const std::int32_t *latency,
+                                                         std::uint32_t begin, std::uint32_t end,
+                                                         const AttributeWindow &window,
+                                                         std::uint32_t *out, std::uint32_t limit) -> std::uint32_t
+{
+    // Inclusive bounds become strict compares: lo - 1 < x < hi + 1
+    const __m256i lo = _mm256_set1_epi32(window.rating_lo - 1);
+    const __m256i hi = _mm256_set1_epi32(window.rating_hi + 1);
+    const __m256i max_lat = _mm256_set1_epi32(window.max_latency_ms + 1);
+
+    std::uint32_t n = 0;
+    std::uint32_t i = begin;
+    for (; i + 8 <= end; i += 8)
+    {
+        __m256i r = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rating + i));
+        __m256i l = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(latency + i));
+        __m256i ok = _mm256_and_si256(_mm256_and_si256(_mm256_cmpgt_epi32(r, lo), _mm256_cmpgt_epi32(hi, r)),
+                                      _mm256_cmpgt_epi32(max_lat, l));
+        auto mask = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(ok)));
+        while (mask != 0)
+        {
+            out[n++] = i + static_cast<std::uint32_t>(__builtin_ctz(mask));
+            if (n == limit)
+                return n;
+            mask &= mask - 1;
+        }
+    }
+    return n + filter_window_scalar(rating, latency, i, end, window, out + n, limit - n);
+}
+
+auto has_avx2() -> bool
+{
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+
+#else
+
+auto filter_window_avx2(const std::int32_t *rating, const std::int32_t *latency,
+                        std::uint32_t begin, std::uint32_t end, const AttributeWindow &window,
+                        std::uint32_t *out, std::uint32_t limit) -> std::uint32_t
+{
+    return filter_window_scalar(rating, latency, begin, end, window, out, limit);
+}
+
+auto has_avx2() -> bool
+{
+    return false;
+}
+
+#endif
+
+auto filter_window(const std::int32_t *rating, const std::int32_t *latency,
+                   std::uint32_t begin, std::uint32_t end, const AttributeWindow &window,
+                   std::uint32_t *out, std::uint32_t limit) -> std::uint32_t
+{
+    if (has_avx2())
+        return filter_window_avx2(rating, latency, begin, end, window, out, limit);
+    return filter_window_scalar(rating, latency, begin, end, window, out, limit);
+}
+
+void PlayerStore::push(const PlayerAttributes &attrs, SimTime arrival_ms)
+{
+    rating_.push_back(attrs.rating);
+    latency_.push_back(attrs.latency_ms);
+    region_.push_back(attrs.region);
+    arrival_.push_back(arrival_ms);
+    ++live_;
+}
+
+auto PlayerStore::find(const AttributeWindow &window, std::uint32_t limit, std::vector<std::uint32_t> &out) const
+    -> std::uint32_t
+{
+    out.resize(limit);
+    auto end = static_cast<std::uint32_t>(rating_.size());
+    std::uint32_t n = filter_window(rating_.data(), latency_.data(), head_, end, window, out.data(), limit);
+    out.resize(n);
+    return n;
+}
+
+auto PlayerStore::nth_live(std::uint32_t n) const -> std::uint32_t
+{
+    for (auto i = head_; i < rating_.size(); ++i)
+    {
+        if (rating_[i] != TOMBSTONE && n-- == 0)
+            return i;
+    }
+    return npos;
+}
+
+void PlayerStore::remove(const std::vector<std::uint32_t> &indices)
+{
+    for (std::uint32_t i : indices)
+    {
+        rating_[i] = TOMBSTONE;
+        --live_;
+    }
+    while (head_ < rating_.size() && rating_[head_] == TOMBSTONE)
+        ++head_;
+
+    std::uint32_t dead = static_cast<std::uint32_t>(rating_.size()) - live_;
+    if (dead > 1024 && dead > live_)
+        compact();
+}
+
+void PlayerStore::compact()
+{
+    std::uint32_t w = 0;
+    for (auto r = head_; r < rating_.size(); ++r)
+    {
+        if (rating_[r] == TOMBSTONE)
+            continue;
+        rating_[w] = rating_[r];
+        latency_[w] = latency_[r];
+        region_[w] = region_[r];
+        arrival_[w] = arrival_[r];
+        ++w;
+    }
+    rating_.resize(w);
+    latency_.resize(w);
+    region_.resize(w);
+    arrival_.resize(w);
+    head_ = 0;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "policies.h"
+
+// Matchmaking attributes carried by each queued player
+struct PlayerAttributes
+{
+    std::int32_t rating = 0;
+    std::int32_t region = 0;
+    std::int32_t latency_ms = 0;
+};
+
+// Acceptance window for a candidate: lo <= rating <= hi and latency <= max_latency
+struct AttributeWindow
+{
+    std::int32_t rating_lo = std::numeric_limits<std::int32_t>::min() + 1;
+    std::int32_t rating_hi = std::numeric_limits<std::int32_t>::max() - 1;
+    std::int32_t max_latency_ms = std::numeric_limits<std::int32_t>::max() - 1;
+};
+
+// ---------------------------------------------------------------------------
+// Bulk filter kernels over attribute columns. Each writes the indices in
+// [begin, end) that fall inside `window` to `out`, in ascending order, and
+// stops after `limit` matches. Returns the number written.
+// ---------------------------------------------------------------------------
+
+auto filter_window_scalar(const std::int32_t *rating, const std::int32_t *latency,
+                          std::uint32_t begin, std::uint32_t end, const AttributeWindow &window,
+                          std::uint32_t *out, std::uint32_t limit) -> std::uint32_t;
+
+// Requires AVX2; see has_avx2()
+auto filter_window_avx2(const std::int32_t *rating, const std::int32_t *latency,
+                        std::uint32_t begin, std::uint32_t end, const AttributeWindow &window,
+                        std::uint32_t *out, std::uint32_t limit) -> std::uint32_t;
+
+auto has_avx2() -> bool;
+
+// Picks the AVX2 kernel when the CPU supports it
+auto filter_window(const std::int32_t *rating, const std::int32_t *latency,
+                   std::uint32_t begin, std::uint32_t end, const AttributeWindow &window,
+                   std::uint32_t *out, std::uint32_t limit) -> std::uint32_t;
+
+// Structure-of-arrays queue of one role's players, oldest first. Removal
+// from the middle leaves a tombstone (a rating no window accepts) so the
+// filter kernels can scan the columns without branching on liveness;
+// tombstones are compacted away once they outnumber live players.
+class PlayerStore
+{
+public:
+    void push(const PlayerAttributes &attrs, SimTime arrival_ms);
+
+    // Indices of up to `limit` oldest live players inside `window`
+    auto find(const AttributeWindow &window, std::uint32_t limit, std::vector<std::uint32_t> &out) const
+        -> std::uint32_t;
+
+    // Index of the n-th oldest live player (n = 0 is the head), or npos
+    [[nodiscard]] auto nth_live(std::uint32_t n) const -> std::uint32_t;
+
+    // Remove the given players; invalidates all indices
+    void remove(const std::vector<std::uint32_t> &indices);
+
+    [[nodiscard]] auto live() const -> std::uint32_t { return live_; }
+    [[nodiscard]] auto attributes(std::uint32_t i) const -> PlayerAttributes
+    {
+        return {rating_[i], region_[i], latency_[i]};
+    }
+    [[nodiscard]] auto arrival(std::uint32_t i) const -> SimTime { return arrival_[i]; }
+
+    static constexpr std::uint32_t npos = std::numeric_limits<std::uint32_t>::max();
+    static constexpr std::int32_t TOMBSTONE = std::numeric_limits<std::int32_t>::min();
+
+private:
+    void compact();
+
+    std::vector<std::int32_t> rating_;
+    std::vector<std::int32_t> latency_;
+    std::vector<std::int32_t> region_;
+    std::vector<SimTime> arrival_;
+    std::uint32_t head_ = 0; // everything before head_ is a tombstone
+    std::uint32_t live_ = 0;
+};
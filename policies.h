@@ -0,0 +1,223 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#ifdef __linux__
+#include <cerrno>
+#include <ctime>
+#endif
+#include "philox.h"
+#include "queue_lock.h"
+#include "utils.h"
+
+// Simulation time in milliseconds since the simulation started
+using SimTime = std::int64_t;
+
+// ---------------------------------------------------------------------------
+// Lock policies: guard the shared role counts and instance table
+// ---------------------------------------------------------------------------
+
+// Real mutex, required by the threaded drivers
+struct MutexLock
+{
+    using mutex_type = std::mutex;
+    static constexpr bool thread_safe = true;
+
+    // Value written under the lock but readable without it (e.g. by a sampler thread)
+    template <typename T>
+    using published = std::atomic<T>;
+};
+
+// FIFO ticket lock: the state lock goes to instance and generator threads in
+// the order they asked for it (see queue_lock.h)
+struct TicketLock
+{
+    using mutex_type = TicketMutex;
+    static constexpr bool thread_safe = true;
+
+    template <typename T>
+    using published = std::atomic<T>;
+};
+
+// FIFO MCS queue lock: like TicketLock, but each waiter spins on its own node
+struct McsLock
+{
+    using mutex_type = McsMutex;
+    static constexpr bool thread_safe = true;
+
+    template <typename T>
+    using published = std::atomic<T>;
+};
+
+// No-op lock for the single-threaded event-driven driver
+struct NoLock
+{
+    struct mutex_type
+    {
+        void lock() noexcept {}
+        void unlock() noexcept {}
+        auto try_lock() noexcept -> bool { return true; }
+    };
+    static constexpr bool thread_safe = false;
+
+    // Plain value with the std::atomic load/store interface; stays copyable
+    template <typename T>
+    struct published
+    {
+        T value{};
+
+        auto load(std::memory_order = std::memory_order_relaxed) const noexcept -> T { return value; }
+        void store(T v, std::memory_order = std::memory_order_relaxed) noexcept { value = v; }
+    };
+};
+
+// ---------------------------------------------------------------------------
+// Log policies: where event and status lines go
+// ---------------------------------------------------------------------------
+
+// Writes each message atomically to stdout
+struct ConsoleLog
+{
+    static constexpr bool enabled = true;
+
+    template <typename... Parts>
+    void write(const Parts &...parts)
+    {
+        std::scoped_lock print_lock(print_mutex);
+        (std::cout << ... << parts);
+    }
+
+    static inline std::mutex print_mutex;
+};
+
+// Discards everything; callers guard formatting with `if constexpr (Log::enabled)`
+struct SilentLog
+{
+    static constexpr bool enabled = false;
+
+    template <typename... Parts>
+    void write(const Parts &...) {}
+};
+
+// ---------------------------------------------------------------------------
+// Clock policies: how time passes
+// ---------------------------------------------------------------------------
+
+// Sleep until `deadline` to within a few microseconds. A kernel timer on the
+// absolute deadline covers all but the last SPIN_SLACK, which is spun off
+// (yielding): a plain sleep overshoots by the timer slack, ~50 us, which is a
+// whole simulated run's worth of error once time is compressed 1000x.
+inline void precise_sleep_until(std::chrono::steady_clock::time_point deadline)
+{
+    constexpr auto SPIN_SLACK = std::chrono::microseconds(60);
+    auto wake = deadline - SPIN_SLACK;
+    if (std::chrono::steady_clock::now() < wake)
+    {
+#ifdef __linux__
+        // steady_clock is CLOCK_MONOTONIC; an absolute deadline does not drift across EINTR
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(wake.time_since_epoch()).count();
+        timespec ts{static_cast<time_t>(ns / 1'000'000'000), static_cast<long>(ns % 1'000'000'000)};
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR)
+        {
+        }
+#else
+        std::this_thread::sleep_until(wake);
+#endif
+    }
+    while (std::chrono::steady_clock::now() < deadline)
+        std::this_thread::yield();
+}
+
+// Real time; sleeping blocks the calling thread. Optionally compressed: with
+// speedup = 100, one simulated second passes every 10 real milliseconds. now()
+// and sleep_for() speak simulated time, so every statistic stays in simulated units.
+struct WallClock
+{
+    static constexpr bool is_virtual = false;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    double speedup = 1.0; // simulated seconds per real second
+
+    [[nodiscard]] auto now() const -> SimTime { return now_us() / 1000; }
+
+    // Finer reading for short intervals such as instance handoffs
+    [[nodiscard]] auto now_us() const -> std::int64_t
+    {
+        auto real_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+        if (speedup == 1.0)
+            return real_us;
+        return static_cast<std::int64_t>(static_cast<double>(real_us) * speedup);
+    }
+
+    void sleep_for(SimTime ms) const
+    {
+        if (speedup == 1.0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+            return;
+        }
+        auto real = std::chrono::nanoseconds(static_cast<std::int64_t>(static_cast<double>(ms) * 1e6 / speedup));
+        precise_sleep_until(std::chrono::steady_clock::now() + real);
+    }
+};
+
+// Simulated time advanced by the event loop; never blocks
+struct VirtualClock
+{
+    static constexpr bool is_virtual = true;
+
+    SimTime current = 0;
+
+    [[nodiscard]] auto now() const -> SimTime { return current; }
+    [[nodiscard]] auto now_us() const -> std::int64_t { return current * 1000; }
+    void advance_to(SimTime t) { current = t; }
+};
+
+// ---------------------------------------------------------------------------
+// RNG policies: source of dungeon durations and generator rolls.
+// duration() draws the length of an instance's n-th run; uniform() serves
+// everything else.
+// ---------------------------------------------------------------------------
+
+// Per-thread generator seeded from random_device (see random_int)
+struct ThreadLocalRng
+{
+    void seed(std::uint64_t) {}
+    auto uniform(int lo, int hi) -> int { return random_int(lo, hi); }
+    auto duration(int, std::uint64_t, int lo, int hi) -> int { return uniform(lo, hi); }
+};
+
+// Counter-based Philox generator. A dungeon's duration is a pure function of
+// (seed, instance id, run index), so it does not depend on which thread asks
+// or when. Other draws number themselves with a shared atomic counter: they
+// are thread-safe, but their order follows the scheduling.
+struct CounterRng
+{
+    std::uint64_t key = 0;
+    std::atomic<std::uint64_t> draws{0};
+
+    CounterRng() = default;
+    CounterRng(const CounterRng &other) : key(other.key), draws(other.draws.load(std::memory_order_relaxed)) {}
+    auto operator=(const CounterRng &other) -> CounterRng &
+    {
+        key = other.key;
+        draws.store(other.draws.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        return *this;
+    }
+
+    void seed(std::uint64_t value) { key = value; }
+    auto uniform(int lo, int hi) -> int
+    {
+        std::uint64_t n = draws.fetch_add(1, std::memory_order_relaxed);
+        return philox_uniform(key, PhiloxStream::General, 0, n, lo, hi);
+    }
+    auto duration(int instance_id, std::uint64_t run, int lo, int hi) const -> int
+    {
+        return philox_uniform(key, PhiloxStream::Duration, static_cast<std::uint32_t>(instance_id), run, lo, hi);
+    }
+};
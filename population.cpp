@@ -0,0 +1,112 @@
+#include "population.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace
+{
+
+// Times past the 32-bit range saturate; only runs longer than 49 days see them
+auto to_ms32(SimTime t) -> std::uint32_t
+{
+    return static_cast<std::uint32_t>(std::clamp<SimTime>(t, 0, std::numeric_limits<std::uint32_t>::max()));
+}
+
+} // namespace
+
+PlayerPopulation::PlayerPopulation(int tanks, int healers, int dps)
+{
+    const std::array<int, ROLE_COUNT> counts = {tanks, healers, dps};
+    returns_.reserve(static_cast<std::size_t>(tanks) + healers + dps);
+    for (int r = 0; r < ROLE_COUNT; ++r)
+        add(r, counts[r], 0);
+}
+
+void PlayerPopulation::add(int role, int count, SimTime now)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        PlayerId id = players_.allocate();
+        PlayerRecord &player = players_[id];
+        player.id = id;
+        player.rating = 1500;
+        player.role_mask = 1U << role;
+        enqueue(id, role, now);
+    }
+}
+
+auto PlayerPopulation::dequeue(int role) -> PlayerId
+{
+    Fifo &queue = queues_[role];
+    PlayerId id = queue.head;
+    PlayerRecord &player = players_[id];
+    queue.head = player.next;
+    if (queue.head == PlayerRecord::NONE)
+        queue.tail = PlayerRecord::NONE;
+    player.next = PlayerRecord::NONE;
+    if (player.runs < PlayerRecord::MAX_RUNS)
+        ++player.runs;
+    return id;
+}
+
+void PlayerPopulation::enqueue(PlayerId id, int role, SimTime now)
+{
+    players_[id].time_ms = to_ms32(now);
+    Fifo &queue = queues_[role];
+    if (queue.tail == PlayerRecord::NONE)
+        queue.head = id;
+    else
+        players_[queue.tail].next = id;
+    queue.tail = id;
+}
+
+auto PlayerPopulation::role_of(PlayerId id) const -> int
+{
+    // Players queue as a single role for now, so the mask has one bit set
+    std::uint32_t mask = players_[id].role_mask;
+    int role = 0;
+    while ((mask & 1U) == 0)
+    {
+        mask >>= 1;
+        ++role;
+    }
+    return role;
+}
+
+void PlayerPopulation::think(PlayerId id, SimTime return_at)
+{
+    players_[id].time_ms = to_ms32(return_at);
+    returns_.push_back(std::uint64_t{players_[id].time_ms} << 32 | id);
+    std::push_heap(returns_.begin(), returns_.end(), std::greater<>{});
+}
+
+auto PlayerPopulation::pop_return() -> PlayerId
+{
+    std::pop_heap(returns_.begin(), returns_.end(), std::greater<>{});
+    auto id = static_cast<PlayerId>(returns_.back());
+    returns_.pop_back();
+    return id;
+}
+
+auto PlayerPopulation::run_stats() const -> RunStats
+{
+    RunStats stats;
+    if (players_.size() == 0)
+        return stats;
+
+    stats.min = PlayerRecord::MAX_RUNS;
+    double total = 0.0;
+    players_.for_each([&stats, &total](const PlayerRecord &player)
+                      {
+                          stats.min = std::min<std::uint32_t>(stats.min, player.runs);
+                          stats.max = std::max<std::uint32_t>(stats.max, player.runs);
+                          total += player.runs;
+                      });
+    stats.mean = total / static_cast<double>(players_.size());
+    return stats;
+}
+
+auto PlayerPopulation::memory_bytes() const -> std::size_t
+{
+    return players_.memory_bytes() + returns_.capacity() * sizeof(std::uint64_t);
+}
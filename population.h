@@ -0,0 +1,152 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "policies.h"
+#include "roles.h"
+
+// One player, bit-packed into 16 bytes. A queued player is linked into its
+// role's FIFO through `next`; `time_ms` is when the player queued or, while
+// thinking, when they come back. Times are 32-bit milliseconds since the run
+// started (49 days), ratings 12 bits and run counts saturate at 2^17 - 1.
+struct PlayerRecord
+{
+    static constexpr std::uint32_t NONE = std::numeric_limits<std::uint32_t>::max();
+    static constexpr std::uint32_t MAX_RUNS = (1U << 17) - 1;
+
+    std::uint32_t id = 0;
+    std::uint32_t next = NONE; // intrusive FIFO link: slot of the player queued after this one
+    std::uint32_t time_ms = 0;
+    std::uint32_t rating : 12 = 0;   // closed-loop players start at 1500
+    std::uint32_t role_mask : 3 = 0; // roles the player queues as, one bit per Role
+    std::uint32_t runs : 17 = 0;     // parties joined
+};
+static_assert(sizeof(PlayerRecord) == 16);
+
+// Records are carved from fixed-size slabs that are never moved or freed,
+// so a slot index stays valid for the life of the pool and growing it never
+// copies existing players. Players are never destroyed in a closed
+// population, so there is no free list.
+template <typename T, std::size_t SlabSize = 4096>
+class SlabPool
+{
+public:
+    using Slot = std::uint32_t;
+
+    auto allocate() -> Slot
+    {
+        if (size_ % SlabSize == 0)
+        {
+            slabs_.emplace_back();
+            slabs_.back().reserve(SlabSize);
+        }
+        slabs_.back().emplace_back();
+        return size_++;
+    }
+
+    [[nodiscard]] auto operator[](Slot slot) -> T & { return slabs_[slot / SlabSize][slot % SlabSize]; }
+    [[nodiscard]] auto operator[](Slot slot) const -> const T & { return slabs_[slot / SlabSize][slot % SlabSize]; }
+    [[nodiscard]] auto size() const -> std::size_t { return size_; }
+
+    template <typename Fn>
+    void for_each(Fn &&fn) const
+    {
+        for (const auto &slab : slabs_)
+            for (const T &item : slab)
+                fn(item);
+    }
+
+    // Bytes held, counting every slab as full
+    [[nodiscard]] auto memory_bytes() const -> std::size_t
+    {
+        return slabs_.size() * SlabSize * sizeof(T) + slabs_.capacity() * sizeof(std::vector<T>);
+    }
+
+private:
+    std::vector<std::vector<T>> slabs_; // each reserved to exactly SlabSize
+    Slot size_ = 0;
+};
+
+// Player population for closed-loop runs: players cycle queue -> party ->
+// thinking -> queue. Each role's queue is an intrusive FIFO through the
+// records, and thinking players wait in a binary heap of 8-byte (return
+// time, slot) keys, which compare without touching the records: 24 bytes per
+// player in total.
+class PlayerPopulation
+{
+public:
+    using PlayerId = std::uint32_t; // slot in the pool
+
+    // Record plus heap key, once the slabs are full
+    static constexpr std::size_t BYTES_PER_PLAYER = sizeof(PlayerRecord) + sizeof(std::uint64_t);
+
+    PlayerPopulation() = default;
+
+    // Creates the players and queues all of them at time 0
+    PlayerPopulation(int tanks, int healers, int dps);
+
+    [[nodiscard]] auto size() const -> std::size_t { return players_.size(); }
+
+    // New players of `role` join the queue at `now`
+    void add(int role, int count, SimTime now);
+
+    // Oldest queued player of `role`, who joins a party; the caller checked
+    // that one is queued
+    auto dequeue(int role) -> PlayerId;
+    [[nodiscard]] auto queued_since(PlayerId id) const -> SimTime { return players_[id].time_ms; }
+
+    // A finished party member re-queues at `return_at`
+    void think(PlayerId id, SimTime return_at);
+
+    // Earliest pending return, or SimTime max if nobody is thinking
+    [[nodiscard]] auto next_return() const -> SimTime
+    {
+        return returns_.empty() ? std::numeric_limits<SimTime>::max() : static_cast<SimTime>(returns_.front() >> 32);
+    }
+
+    // Re-queue every player due by `now`, calling on_return(role) for each
+    template <typename OnReturn>
+    auto release_due(SimTime now, OnReturn &&on_return) -> int
+    {
+        int released = 0;
+        while (!returns_.empty() && static_cast<SimTime>(returns_.front() >> 32) <= now)
+        {
+            PlayerId id = pop_return();
+            int role = role_of(id);
+            enqueue(id, role, players_[id].time_ms);
+            on_return(role);
+            ++released;
+        }
+        return released;
+    }
+
+    struct RunStats
+    {
+        double mean = 0.0;
+        std::uint32_t min = 0;
+        std::uint32_t max = 0;
+    };
+
+    // Parties joined per player
+    [[nodiscard]] auto run_stats() const -> RunStats;
+
+    // Heap memory held by the population
+    [[nodiscard]] auto memory_bytes() const -> std::size_t;
+
+private:
+    struct Fifo
+    {
+        PlayerId head = PlayerRecord::NONE;
+        PlayerId tail = PlayerRecord::NONE;
+    };
+
+    [[nodiscard]] auto role_of(PlayerId id) const -> int;
+    void enqueue(PlayerId id, int role, SimTime now);
+    auto pop_return() -> PlayerId;
+
+    SlabPool<PlayerRecord> players_;
+    std::array<Fifo, ROLE_COUNT> queues_;
+    std::vector<std::uint64_t> returns_; // min-heap of (return time << 32 | slot)
+};
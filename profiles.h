@@ -0,0 +1,92 @@
+#pragma once
+#include "policies.h"
+#include "simulation.h"
+
+// Compile-time configuration profiles. Each one fully specializes
+// Simulation<>; nothing in a profile is checked at run time. `generator`
+// is the default set of knobs, overridable from a config file.
+
+// Interactive run: one thread per instance, real sleeps, console output
+struct WallClockProfile
+{
+    using Lock = MutexLock;
+    using Log = ConsoleLog;
+    using Clock = WallClock;
+    using Rng = CounterRng;
+    static constexpr GeneratorConfig generator{};
+    static constexpr WallDriver driver = WallDriver::SharedLock;
+};
+
+// Same as WallClockProfile, with a FIFO ticket lock on the shared state
+struct TicketLockProfile
+{
+    using Lock = TicketLock;
+    using Log = ConsoleLog;
+    using Clock = WallClock;
+    using Rng = CounterRng;
+    static constexpr GeneratorConfig generator{};
+    static constexpr WallDriver driver = WallDriver::SharedLock;
+};
+
+// Same as WallClockProfile, with an MCS queue lock on the shared state
+struct McsLockProfile
+{
+    using Lock = McsLock;
+    using Log = ConsoleLog;
+    using Clock = WallClock;
+    using Rng = CounterRng;
+    static constexpr GeneratorConfig generator{};
+    static constexpr WallDriver driver = WallDriver::SharedLock;
+};
+
+// Same as WallClockProfile, but one matcher thread owns the queue state and
+// instance/generator threads message it through a lock-free MPSC queue
+struct CentralMatcherProfile
+{
+    using Lock = MutexLock;
+    using Log = ConsoleLog;
+    using Clock = WallClock;
+    using Rng = CounterRng;
+    static constexpr GeneratorConfig generator{};
+    static constexpr WallDriver driver = WallDriver::CentralMatcher;
+};
+
+// Same as WallClockProfile, but arrival, matching, dispatch and completion
+// are separate stages linked by preallocated rings (see disruptor.h)
+struct PipelineProfile
+{
+    using Lock = MutexLock;
+    using Log = ConsoleLog;
+    using Clock = WallClock;
+    using Rng = CounterRng;
+    static constexpr GeneratorConfig generator{};
+    static constexpr WallDriver driver = WallDriver::Pipeline;
+};
+
+// Batch run: single-threaded, lock-free, silent, simulated time, seeded RNG
+struct SilentVirtualProfile
+{
+    using Lock = NoLock;
+    using Log = SilentLog;
+    using Clock = VirtualClock;
+    using Rng = CounterRng;
+    static constexpr GeneratorConfig generator{};
+};
+
+// Same as SilentVirtualProfile but prints every event, for debugging
+struct VerboseVirtualProfile
+{
+    using Lock = NoLock;
+    using Log = ConsoleLog;
+    using Clock = VirtualClock;
+    using Rng = CounterRng;
+    static constexpr GeneratorConfig generator{};
+};
+
+using WallClockSimulation = Simulation<WallClockProfile>;
+using TicketLockSimulation = Simulation<TicketLockProfile>;
+using McsLockSimulation = Simulation<McsLockProfile>;
+using CentralMatcherSimulation = Simulation<CentralMatcherProfile>;
+using PipelineSimulation = Simulation<PipelineProfile>;
+using SilentVirtualSimulation = Simulation<SilentVirtualProfile>;
+using VerboseVirtualSimulation = Simulation<VerboseVirtualProfile>;
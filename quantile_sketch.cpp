@@ -0,0 +1,197 @@
+#include "quantile_sketch.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <utility>
+
+namespace
+{
+
+constexpr std::size_t MIN_WIDTH = 8;
+constexpr double SHRINK = 2.0 / 3.0;
+
+} // namespace
+
+QuantileSketch::QuantileSketch(int k) : k_(k), levels_(1), total_capacity_(capacity(0))
+{
+}
+
+void QuantileSketch::add(double value)
+{
+    if (count_ == 0)
+    {
+        min_ = value;
+        max_ = value;
+    }
+    else
+    {
+        min_ = std::min(min_, value);
+        max_ = std::max(max_, value);
+    }
+    ++count_;
+    sum_ += value;
+
+    levels_[0].push_back(value);
+    if (++retained_ >= total_capacity_)
+        compress();
+}
+
+void QuantileSketch::merge(const QuantileSketch &other)
+{
+    if (other.count_ == 0)
+        return;
+    if (count_ == 0)
+    {
+        min_ = other.min_;
+        max_ = other.max_;
+    }
+    else
+    {
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+    }
+    count_ += other.count_;
+    sum_ += other.sum_;
+
+    if (levels_.size() < other.levels_.size())
+    {
+        levels_.resize(other.levels_.size());
+        total_capacity_ = total_capacity();
+    }
+    for (std::size_t h = 0; h < other.levels_.size(); ++h)
+        levels_[h].insert(levels_[h].end(), other.levels_[h].begin(), other.levels_[h].end());
+    retained_ += other.retained_;
+    if (retained_ >= total_capacity_)
+        compress();
+}
+
+void QuantileSketch::clear()
+{
+    for (auto &level : levels_)
+        level.clear();
+    levels_.resize(1);
+    retained_ = 0;
+    total_capacity_ = capacity(0);
+    count_ = 0;
+    sum_ = 0.0;
+    min_ = 0.0;
+    max_ = 0.0;
+}
+
+auto QuantileSketch::capacity(std::size_t level) const -> std::size_t
+{
+    auto depth = static_cast<double>(levels_.size() - 1 - level);
+    auto width = static_cast<std::size_t>(static_cast<double>(k_) * std::pow(SHRINK, depth));
+    return std::max(width, MIN_WIDTH);
+}
+
+auto QuantileSketch::total_capacity() const -> std::size_t
+{
+    std::size_t total = 0;
+    for (std::size_t h = 0; h < levels_.size(); ++h)
+        total += capacity(h);
+    return total;
+}
+
+// While the sketch holds more than all its levels' capacities together,
+// compact the lowest level that is over its own. Lower levels shrink as the
+// sketch grows taller, so a merge may need several rounds.
+void QuantileSketch::compress()
+{
+    while (retained_ >= total_capacity_)
+    {
+        std::size_t h = 0;
+        while (levels_[h].size() < capacity(h))
+            ++h;
+        compact(h);
+    }
+}
+
+void QuantileSketch::compact(std::size_t level)
+{
+    if (level + 1 == levels_.size())
+    {
+        levels_.emplace_back();
+        total_capacity_ = total_capacity();
+    }
+
+    std::vector<double> &items = levels_[level];
+    std::sort(items.begin(), items.end());
+
+    // An odd item out stays behind so the total weight is unchanged
+    double leftover = 0.0;
+    bool odd = items.size() % 2 != 0;
+    if (odd)
+    {
+        leftover = items.back();
+        items.pop_back();
+    }
+
+    // Fold in the data so sketches that are later merged flip different coins
+    coin_ ^= std::bit_cast<std::uint64_t>(items[items.size() / 2]);
+    coin_ ^= coin_ << 13;
+    coin_ ^= coin_ >> 7;
+    coin_ ^= coin_ << 17;
+    std::vector<double> &above = levels_[level + 1];
+    for (std::size_t i = coin_ & 1U; i < items.size(); i += 2)
+        above.push_back(items[i]);
+
+    retained_ -= items.size() / 2;
+    items.clear();
+    // Level 0 buffers new values; a higher level that held more while it was
+    // near the top gives the memory back
+    if (level > 0 && items.capacity() > 2 * capacity(level))
+        items.shrink_to_fit();
+    if (odd)
+        items.push_back(leftover);
+}
+
+auto QuantileSketch::quantile(double q) const -> double
+{
+    if (count_ == 0)
+        return 0.0;
+
+    std::vector<std::pair<double, std::uint64_t>> weighted;
+    weighted.reserve(retained_);
+    for (std::size_t h = 0; h < levels_.size(); ++h)
+    {
+        for (double value : levels_[h])
+            weighted.emplace_back(value, std::uint64_t{1} << h);
+    }
+    std::sort(weighted.begin(), weighted.end());
+
+    // An item of weight w stands for w values centred on its rank range;
+    // interpolate between those centres (and the exact min and max at the
+    // ends). With every weight 1 this is plain linear interpolation between
+    // the sorted values.
+    double target = q * static_cast<double>(count_ - 1);
+    double prev_pos = 0.0;
+    double prev_value = min_;
+    double seen = 0.0;
+    for (const auto &[value, weight] : weighted)
+    {
+        double pos = seen + (static_cast<double>(weight) - 1.0) / 2.0;
+        if (pos >= target)
+        {
+            if (pos == prev_pos)
+                return value;
+            return prev_value + (value - prev_value) * (target - prev_pos) / (pos - prev_pos);
+        }
+        prev_pos = pos;
+        prev_value = value;
+        seen += static_cast<double>(weight);
+    }
+    double last_pos = static_cast<double>(count_ - 1);
+    if (last_pos == prev_pos)
+        return max_;
+    return prev_value + (max_ - prev_value) * (target - prev_pos) / (last_pos - prev_pos);
+}
+
+auto QuantileSketch::memory_bytes() const -> std::size_t
+{
+    std::size_t bytes = levels_.capacity() * sizeof(std::vector<double>);
+    for (const auto &level : levels_)
+        bytes += level.capacity() * sizeof(double);
+    return bytes;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// KLL streaming quantile sketch (Karnin, Lang & Liberty 2016). Values enter
+// level 0; a level that outgrows its capacity is sorted and every other item
+// is promoted to the level above with twice the weight. Capacities shrink by
+// 2/3 per level below the top, so memory stays around 3k values however many
+// are added, and ranks are off by roughly 1.7 / k of the count.
+//
+// Sketches merge level by level, so each thread or instance can keep its own
+// and the summary combines them. Count, mean, min and max are exact, and so
+// are quantiles until the first compaction (at k values).
+class QuantileSketch
+{
+public:
+    static constexpr int DEFAULT_K = 200;
+
+    explicit QuantileSketch(int k = DEFAULT_K);
+
+    void add(double value);
+    void merge(const QuantileSketch &other);
+    void clear();
+
+    [[nodiscard]] auto count() const -> std::uint64_t { return count_; }
+    [[nodiscard]] auto mean() const -> double { return count_ > 0 ? sum_ / static_cast<double>(count_) : 0.0; }
+    [[nodiscard]] auto min() const -> double { return min_; }
+    [[nodiscard]] auto max() const -> double { return max_; }
+
+    // Value at quantile q in [0, 1], linearly interpolated between ranks (exact
+    // while the sketch still holds every value); 0 when empty
+    [[nodiscard]] auto quantile(double q) const -> double;
+
+    // Values currently held, and the heap memory behind them
+    [[nodiscard]] auto retained() const -> std::size_t { return retained_; }
+    [[nodiscard]] auto memory_bytes() const -> std::size_t;
+
+private:
+    [[nodiscard]] auto capacity(std::size_t level) const -> std::size_t;
+    [[nodiscard]] auto total_capacity() const -> std::size_t;
+    void compress();
+    void compact(std::size_t level);
+
+    int k_;
+    std::vector<std::vector<double>> levels_; // level h items weigh 2^h
+    std::size_t retained_ = 0;
+    std::size_t total_capacity_;              // sum of capacity() over the levels
+    std::uint64_t count_ = 0;
+    double sum_ = 0.0;
+    double min_ = 0.0;
+    double max_ = 0.0;
+    std::uint64_t coin_ = 0x9E3779B97F4A7C15ULL; // picks odd or even survivors; fixed so runs repeat
+};
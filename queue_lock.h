@@ -0,0 +1,122 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include "parker.h"
+
+// FIFO spin locks for the engine's state lock. std::mutex hands the lock to
+// whichever thread wins the race, so a thread can lose it over and over;
+// these grant it strictly in arrival order. Both meet the Lockable
+// requirements, so std::scoped_lock and std::unique_lock work unchanged.
+
+// Waiting for a queue lock: pause a few rounds, then yield, because with
+// strict hand-off order a descheduled holder or next-in-line stalls every
+// thread behind it until it runs again
+class QueueBackoff
+{
+public:
+    void wait()
+    {
+        if (++rounds_ < SPIN_ROUNDS)
+            cpu_relax();
+        else
+            std::this_thread::yield();
+    }
+
+private:
+    static constexpr int SPIN_ROUNDS = 64;
+    int rounds_ = 0;
+};
+
+// Ticket lock: take a number, wait until it is served. Two counters, but
+// every waiter spins on the same `serving_` line, so each hand-off
+// invalidates it in every waiting core's cache.
+class TicketMutex
+{
+public:
+    void lock() noexcept
+    {
+        std::uint32_t ticket = next_.fetch_add(1, std::memory_order_relaxed);
+        QueueBackoff backoff;
+        while (serving_.load(std::memory_order_acquire) != ticket)
+            backoff.wait();
+    }
+
+    auto try_lock() noexcept -> bool
+    {
+        std::uint32_t serving = serving_.load(std::memory_order_acquire);
+        return next_.compare_exchange_strong(serving, serving + 1, std::memory_order_acquire,
+                                             std::memory_order_relaxed);
+    }
+
+    // Only the holder writes serving_
+    void unlock() noexcept { serving_.store(serving_.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+private:
+    alignas(64) std::atomic<std::uint32_t> next_{0};
+    alignas(64) std::atomic<std::uint32_t> serving_{0};
+};
+
+// MCS queue lock (Mellor-Crummey & Scott 1991): waiters form a linked list
+// and each spins on its own node, so a hand-off touches only the next
+// waiter's cache line. Nodes are per thread, so a thread may hold only one
+// McsMutex at a time, which is all the engine needs.
+class McsMutex
+{
+public:
+    void lock() noexcept
+    {
+        Node &me = local_node();
+        me.next.store(nullptr, std::memory_order_relaxed);
+        me.locked.store(true, std::memory_order_relaxed);
+        Node *prev = tail_.exchange(&me, std::memory_order_acq_rel);
+        if (prev == nullptr)
+            return;
+        prev->next.store(&me, std::memory_order_release);
+        QueueBackoff backoff;
+        while (me.locked.load(std::memory_order_acquire))
+            backoff.wait();
+    }
+
+    auto try_lock() noexcept -> bool
+    {
+        Node &me = local_node();
+        me.next.store(nullptr, std::memory_order_relaxed);
+        Node *expected = nullptr;
+        return tail_.compare_exchange_strong(expected, &me, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    void unlock() noexcept
+    {
+        Node &me = local_node();
+        Node *succ = me.next.load(std::memory_order_acquire);
+        if (succ == nullptr)
+        {
+            // Nobody queued: release outright, unless a waiter swapped in
+            // behind us and has yet to link itself
+            Node *expected = &me;
+            if (tail_.compare_exchange_strong(expected, nullptr, std::memory_order_release,
+                                              std::memory_order_relaxed))
+                return;
+            QueueBackoff backoff;
+            while ((succ = me.next.load(std::memory_order_acquire)) == nullptr)
+                backoff.wait();
+        }
+        succ->locked.store(false, std::memory_order_release);
+    }
+
+private:
+    struct alignas(64) Node
+    {
+        std::atomic<Node *> next{nullptr};
+        std::atomic<bool> locked{false};
+    };
+
+    static auto local_node() -> Node &
+    {
+        thread_local Node node;
+        return node;
+    }
+
+    std::atomic<Node *> tail_{nullptr};
+};
@@ -0,0 +1,27 @@
+#pragma once
+#include <string_view>
+
+// Player roles, usable as array indices
+enum class Role
+{
+    Tank,
+    Healer,
+    Dps
+};
+
+constexpr int ROLE_COUNT = 3;
+
+constexpr auto role_to_string(Role role) -> std::string_view
+{
+    switch (role)
+    {
+    case Role::Tank:
+        return "Tanks";
+    case Role::Healer:
+        return "Healers";
+    case Role::Dps:
+        return "DPS";
+    default:
+        return "unknown";
+    }
+}
@@ -0,0 +1,22 @@
+#include "sampler.h"
+
+#include "format.h"
+
+void write_samples_csv(std::ostream &out, const std::vector<Sample> &samples, int instances)
+{
+    out << "time_s,tanks,healers,dps,active_instances,utilization,parties_formed,formation_rate\n";
+    FormatBuffer<128> row;
+    for (const Sample &s : samples)
+    {
+        row.clear();
+        row.append_fixed<3>(static_cast<double>(s.time_ms) / 1000.0).append(',')
+            .append(s.probe.tanks).append(',')
+            .append(s.probe.healers).append(',')
+            .append(s.probe.dps).append(',')
+            .append(s.probe.active_instances).append(',')
+            .append_fixed<3>(static_cast<double>(s.probe.active_instances) / instances).append(',')
+            .append(s.probe.parties_formed).append(',')
+            .append_fixed<3>(s.formation_rate).append('\n');
+        out << row;
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <ostream>
+#include <vector>
+#include "policies.h"
+
+// Point-in-time view of the queue, read from the engine's published counters
+struct QueueProbe
+{
+    int tanks = 0;
+    int healers = 0;
+    int dps = 0;
+    int active_instances = 0;
+    long long parties_formed = 0; // cumulative
+};
+
+struct Sample
+{
+    SimTime time_ms = 0;
+    QueueProbe probe;
+    double formation_rate = 0.0; // parties per second since the previous sample
+};
+
+// Fixed-capacity ring of samples. Storage is allocated once up front; when the
+// ring is full the oldest sample is overwritten and counted as dropped.
+class SampleRing
+{
+public:
+    explicit SampleRing(std::size_t capacity = 0) : ring_(capacity) {}
+
+    void record(SimTime time_ms, const QueueProbe &probe)
+    {
+        if (ring_.empty())
+            return;
+
+        Sample sample{time_ms, probe, 0.0};
+        if (count_ > 0 && time_ms > last_time_)
+        {
+            sample.formation_rate = static_cast<double>(probe.parties_formed - last_formed_) * 1000.0 /
+                                    static_cast<double>(time_ms - last_time_);
+        }
+        last_time_ = time_ms;
+        last_formed_ = probe.parties_formed;
+
+        ring_[head_] = sample;
+        head_ = (head_ + 1) % ring_.size();
+        if (count_ < ring_.size())
+            ++count_;
+        else
+            ++dropped_;
+    }
+
+    [[nodiscard]] auto enabled() const -> bool { return !ring_.empty(); }
+    [[nodiscard]] auto dropped() const -> std::size_t { return dropped_; }
+
+    // Samples oldest first
+    [[nodiscard]] auto ordered() const -> std::vector<Sample>
+    {
+        std::vector<Sample> out;
+        out.reserve(count_);
+        std::size_t start = (head_ + ring_.size() - count_) % std::max<std::size_t>(ring_.size(), 1);
+        for (std::size_t i = 0; i < count_; ++i)
+        {
+            out.push_back(ring_[(start + i) % ring_.size()]);
+        }
+        return out;
+    }
+
+private:
+    std::vector<Sample> ring_;
+    std::size_t head_ = 0;
+    std::size_t count_ = 0;
+    std::size_t dropped_ = 0;
+    SimTime last_time_ = 0;
+    long long last_formed_ = 0;
+};
+
+void write_samples_csv(std::ostream &out, const std::vector<Sample> &samples, int instances);
@@ -0,0 +1,105 @@
+#include "scenario.h"
+
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string_view>
+#include "roles.h"
+#include "utils.h"
+
+namespace
+{
+
+// "tanks" / "healers" / "dps" / "all" (-1)
+auto parse_role(std::string_view text, int &role) -> bool
+{
+    if (text == "tanks")
+        role = static_cast<int>(Role::Tank);
+    else if (text == "healers")
+        role = static_cast<int>(Role::Healer);
+    else if (text == "dps")
+        role = static_cast<int>(Role::Dps);
+    else if (text == "all")
+        role = -1;
+    else
+        return false;
+    return true;
+}
+
+auto parse_event(const std::string &line, ScenarioEvent &event) -> bool
+{
+    std::istringstream words(line);
+    std::string at, action, first, second, extra;
+    words >> at >> action >> first >> second >> extra;
+    if (!extra.empty() || !parse_number(at, event.at_s) || !std::isfinite(event.at_s) || event.at_s < 0.0)
+        return false;
+
+    int count = 0;
+    if (action == "add")
+    {
+        event.action = ScenarioEvent::Action::AddPlayers;
+        if (!parse_role(first, event.role) || !parse_number(second, count) || count < 0)
+            return false;
+        event.value = count;
+    }
+    else if (action == "rate")
+    {
+        event.action = ScenarioEvent::Action::Rate;
+        if (!parse_role(first, event.role) || !parse_number(second, event.value) || !std::isfinite(event.value) ||
+            event.value < 0.0)
+            return false;
+    }
+    else if (action == "offline" || action == "online")
+    {
+        event.action = action == "offline" ? ScenarioEvent::Action::Offline : ScenarioEvent::Action::Online;
+        if (!second.empty() || !parse_number(first, count) || count < 0)
+            return false;
+        event.value = count;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+auto load_scenario(const std::string &path, std::vector<ScenarioEvent> &events, std::string &error) -> bool
+{
+    std::ifstream in(path);
+    if (!in)
+    {
+        error = "cannot open scenario file " + path;
+        return false;
+    }
+
+    std::vector<ScenarioEvent> loaded;
+    std::string raw;
+    int line_no = 0;
+    while (std::getline(in, raw))
+    {
+        ++line_no;
+        if (auto hash = raw.find('#'); hash != std::string::npos)
+            raw.erase(hash);
+        if (raw.find_first_not_of(" \t\r") == std::string::npos)
+            continue;
+
+        ScenarioEvent event;
+        if (!parse_event(raw, event))
+        {
+            error = path + ":" + std::to_string(line_no) +
+                    ": expected <seconds> add <role> <n> | offline <n> | online <n> | rate <role> <factor>";
+            return false;
+        }
+        if (!loaded.empty() && event.at_s < loaded.back().at_s)
+        {
+            error = path + ":" + std::to_string(line_no) + ": event times must not decrease";
+            return false;
+        }
+        loaded.push_back(event);
+    }
+
+    events = std::move(loaded);
+    return true;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// Timed events injected into a run. File format: one event per line,
+// `#` starts a comment, times in simulated seconds and non-decreasing.
+//
+//   300  add      tanks 500    # queue 500 extra tanks
+//   600  offline  20           # 20 instances stop taking parties after their current run
+//   900  online   20           # bring 20 of them back
+//   900  rate     dps 2        # generator waves carry 2x the usual DPS (all = every role)
+struct ScenarioEvent
+{
+    enum class Action
+    {
+        AddPlayers,
+        Offline,
+        Online,
+        Rate
+    };
+
+    double at_s = 0.0;
+    Action action = Action::AddPlayers;
+    int role = -1;      // AddPlayers / Rate: Role index, -1 = every role
+    double value = 0.0; // player or instance count, or rate factor
+};
+
+// On failure returns false, leaves `events` untouched and describes the
+// problem in `error`
+auto load_scenario(const std::string &path, std::vector<ScenarioEvent> &events, std::string &error) -> bool;
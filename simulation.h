@@ -0,0 +1,2395 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "arrival_curve.h"
+#include "arrival_queue.h"
+#include "disruptor.h"
+#include "format.h"
+#include "matchmaker.h"
+#include "mpsc_queue.h"
+#include "parker.h"
+#include "player_store.h"
+#include "policies.h"
+#include "population.h"
+#include "quantile_sketch.h"
+#include "roles.h"
+#include "sampler.h"
+#include "scenario.h"
+
+// Output limits
+constexpr int MAX_INSTANCES = 100;
+constexpr std::size_t STATUS_FIELD_WIDTH = 12;
+
+// Parallel generator threads allowed in one run
+constexpr int MAX_GENERATOR_THREADS = 64;
+
+// One "[Status] I0:active ..." line, sized for the largest allowed instance count
+using StatusLine = FormatBuffer<16 + MAX_INSTANCES * STATUS_FIELD_WIDTH>;
+
+// Enum for instance status
+enum class InstanceStatus
+{
+    Empty,
+    Active,
+    Offline // taken out of service by a scenario
+};
+
+// Helper function to convert InstanceStatus to string
+constexpr auto status_to_string(InstanceStatus status) -> std::string_view
+{
+    switch (status)
+    {
+    case InstanceStatus::Empty:
+        return "empty";
+    case InstanceStatus::Active:
+        return "active";
+    case InstanceStatus::Offline:
+        return "offline";
+    default:
+        return "unknown";
+    }
+}
+
+// Structure to represent a dungeon instance
+struct Instance
+{
+    InstanceStatus status = InstanceStatus::Empty;
+    int served = 0;           // number of parties served
+    long long total_time = 0; // total time served
+};
+
+// Bonus player generation knobs
+struct GeneratorConfig
+{
+    int check_interval_ms = 500;         // check every 500 ms
+    double generation_probability = 0.3; // 30% chance to generate players each check
+
+    // Balance: Tanks and healers are rarer than DPS
+    int min_tanks_per_wave = 0;
+    int max_tanks_per_wave = 2;
+
+    int min_healers_per_wave = 0;
+    int max_healers_per_wave = 2;
+
+    int min_dps_per_wave = 0;
+    int max_dps_per_wave = 5;
+};
+
+// Role composition of one party
+struct PartyTemplate
+{
+    int tanks = 1;
+    int healers = 1;
+    int dps = 3;
+};
+
+// Simulation parameters from the command line and/or a config file
+struct SimulationParams
+{
+    int instances = 1;       // number of concurrent dungeon instances
+    int tanks = 0;           // initial players per role
+    int healers = 0;
+    int dps = 0;
+    int t1 = 1;              // min/max time to complete dungeon
+    int t2 = 1;
+    int bonus_duration = 0;  // in seconds, 0 = infinite
+    std::uint64_t seed = 0;  // keys the RNG policy; ThreadLocalRng ignores it
+    bool seed_given = false; // a config file set `seed`; otherwise main() draws a random one
+    int sample_interval_ms = 0;          // queue-depth sampling period, 0 = off
+    std::size_t sample_capacity = 4096;  // ring size; older samples are overwritten
+    int rating_window = 0;   // > 0: attribute matching, party ratings within +/- this of the anchor
+    int max_latency_ms = 0;  // attribute matching: reject players above this latency, 0 = no limit
+    int regions = 1;                 // > 1: region-tagged instance pools (instance i in region i % regions)
+    int region_penalty_ms = 80;      // latency added per hop to a remote region
+    int latency_relax_ms_per_s = 0;  // latency cap grows this much per second the anchor waits
+    int lookahead_ms = 0;    // > 0: reserve the next party this long before a run ends
+    bool closed_loop = false; // player population: party members re-queue after a think time
+    int think_ms = 5000;      // closed loop: mean (exponential) think time between runs
+    PartyTemplate party;
+    std::optional<GeneratorConfig> generator; // unset = the profile's compile-time defaults
+    ArrivalCurve arrivals;    // active: waves arrive as a non-homogeneous Poisson process
+    std::vector<ScenarioEvent> scenario; // timed events; shared-lock and virtual drivers only
+    double speedup = 1.0;     // wall clock: simulated seconds per real second
+    int idle_spins = -1;      // shared-lock driver: spin rounds before an idle instance sleeps, -1 = auto
+    int generator_threads = 1; // shared-lock and matcher drivers: threads rolling waves, each at the full rate
+    int generator_batch = 0;   // players a generator thread buffers before handing them over, 0 = every wave
+    int bonus_lead_ms = 0;     // > 0: start bonus generation when the initial players are forecast to run out this soon
+};
+
+// How a wall-clock profile coordinates its threads
+enum class WallDriver
+{
+    SharedLock,     // instance threads share the state under the profile's lock
+    CentralMatcher, // one matcher thread owns the state; the others message it
+    Pipeline        // arrival -> match -> dispatch -> complete stages linked by rings
+};
+
+// Work done by one pipeline stage
+struct StageStats
+{
+    std::string_view name;
+    long long events = 0;
+    double latency_us = 0.0; // mean wait between the upstream publish and this stage taking the event
+};
+
+// Closed-loop population summary
+struct PopulationStats
+{
+    std::size_t players = 0; // 0 = open model
+    std::size_t memory_bytes = 0;
+    double runs_mean = 0.0;  // parties joined per player
+    std::uint32_t runs_min = 0;
+    std::uint32_t runs_max = 0;
+};
+
+// Streaming distributions of one instance, merged across instances for the summary
+struct InstanceDistributions
+{
+    std::array<QuantileSketch, ROLE_COUNT> waits_s; // queue wait of each player the instance took
+    QuantileSketch runs_s;                           // dungeon run durations
+};
+
+// Time-weighted blame for lost throughput, accumulated while the simulation runs
+struct BottleneckStats
+{
+    // Instance-seconds spent empty because this role was the scarcest one
+    std::array<double, ROLE_COUNT> idle_instance_s{};
+    // Party-seconds a formable party waited because every instance was busy
+    double waiting_party_s = 0.0;
+    // The same, and the parties formed, once the initial players are used up:
+    // the steady state the queueing model predicts a party's wait for
+    double bonus_waiting_party_s = 0.0;
+    long long bonus_parties = 0;
+    // Instance-seconds spent empty in the first t1 + t2 seconds after the
+    // initial players ran out: the hand-over to bonus generation
+    double transition_idle_instance_s = 0.0;
+    SimTime initial_exhausted_ms = -1; // when the last initial party formed, -1 = never
+    SimTime bonus_started_ms = -1;     // when bonus generation was switched on, -1 = never
+};
+
+// Final state handed back to main() for the summary
+struct SimulationResult
+{
+    BottleneckStats bottleneck;
+    std::vector<InstanceDistributions> distributions; // one per instance
+    double mean_latency_ms = 0.0; // attribute matching: latency of matched players to their instance
+    int regions = 1;
+    double idle_between_runs_ms = 0.0; // total time instances sat empty between two runs
+    double idle_between_runs_max_ms = 0.0;
+    long long handoffs = 0;            // runs that followed an earlier run on the same instance
+    int scenario_events = 0;           // scenario events applied before the end
+    int scenario_scripted = 0;         // events in the scenario file
+    std::array<int, ROLE_COUNT> scenario_players{}; // players queued by scenario events
+    std::vector<StageStats> stages;    // pipeline driver only
+    PopulationStats population;
+    std::vector<Sample> samples; // oldest first
+    std::size_t samples_dropped = 0;
+    std::vector<Instance> instances;
+    int online_instances = 0; // instances not taken offline at the end
+    int bonus_tanks_added = 0;
+    int bonus_healers_added = 0;
+    int bonus_dps_added = 0;
+    int remaining_tanks = 0;
+    int remaining_healers = 0;
+    int remaining_dps = 0;
+    SimTime elapsed_ms = 0;
+};
+
+// LFG queue engine. `Profile` supplies the Lock, Log, Clock and Rng policies
+// plus the compile-time generator knobs; see profiles.h. Wall-clock profiles
+// run one thread per instance, coordinated as their `driver` says;
+// virtual-clock profiles run a single-threaded discrete-event loop. The
+// choice is made at compile time.
+template <typename Profile>
+class Simulation
+{
+public:
+    using Lock = typename Profile::Lock;
+    using Log = typename Profile::Log;
+    using Clock = typename Profile::Clock;
+    using Rng = typename Profile::Rng;
+
+    explicit Simulation(const SimulationParams &params)
+        : params_(params),
+          instances_(params.instances),
+          distributions_(params.instances),
+          handoffs_(params.instances),
+          tanks_(params.tanks),
+          healers_(params.healers),
+          dps_(params.dps),
+          generator_(params.generator.value_or(Profile::generator)),
+          matchmaker_(match_config()),
+          samples_(params.sample_interval_ms > 0 ? params.sample_capacity : 0)
+    {
+        rng_.seed(params.seed);
+        if constexpr (!Clock::is_virtual)
+            clock_.speedup = params.speedup;
+        offline_.assign(params.instances, 0);
+        for (auto &scale : rate_scale_)
+            scale.store(1.0);
+        if (params.closed_loop)
+        {
+            // No bonus players: the generator only keeps time and the population cycles
+            population_ = PlayerPopulation(tanks_, healers_, dps_);
+            std::size_t party_size = static_cast<std::size_t>(params.party.tanks) + params.party.healers + params.party.dps;
+            members_.assign(params.instances * party_size, 0);
+            next_members_.assign(params.instances * party_size, 0);
+            bonus_mode_active_ = true;
+        }
+        else
+        {
+            enqueue(Role::Tank, tanks_, 0);
+            enqueue(Role::Healer, healers_, 0);
+            enqueue(Role::Dps, dps_, 0);
+        }
+        matchmaker_.refresh(0);
+        if (!params.closed_loop)
+            initial_parties_left_ = formable_parties();
+        publish_counts();
+    }
+
+    void run()
+    {
+        if constexpr (Clock::is_virtual)
+        {
+            run_until(std::numeric_limits<SimTime>::max());
+        }
+        else if constexpr (Profile::driver == WallDriver::CentralMatcher)
+        {
+            run_matcher();
+        }
+        else if constexpr (Profile::driver == WallDriver::Pipeline)
+        {
+            run_pipeline();
+        }
+        else
+        {
+            run_threads();
+        }
+    }
+
+    // Event driver: process every event up to `until` and stop. The engine is
+    // copyable, so a paused run is a warm state that can be cloned and resumed
+    // with run() or run_until() any number of times.
+    void run_until(SimTime until)
+    {
+        static_assert(Clock::is_virtual, "only the event driver can pause");
+        if (!events_started_)
+        {
+            events_started_ = true;
+            start_events();
+        }
+        run_events(until);
+    }
+
+    // Event driver, while paused: change the pool size. New instances start
+    // looking for parties at once; surplus ones go offline after their current run.
+    void resize_pool(int instances)
+    {
+        static_assert(Clock::is_virtual, "thread-per-instance drivers cannot resize");
+        int current = params_.instances;
+        if (instances > current)
+        {
+            instances_.resize(instances);
+            handoffs_.resize(instances);
+            distributions_.resize(instances);
+            offline_.resize(instances, 0);
+            if (params_.closed_loop)
+            {
+                members_.resize(instances * party_size());
+                next_members_.resize(instances * party_size());
+            }
+            params_.instances = instances;
+        }
+        for (int i = 0; i < params_.instances; ++i)
+        {
+            bool surplus = i >= instances;
+            if (offline_[i] == surplus)
+                continue;
+            offline_[i] = surplus;
+            offline_count_ += surplus ? 1 : -1;
+            if (instances_[i].status != InstanceStatus::Active)
+                instances_[i].status = surplus ? InstanceStatus::Offline : InstanceStatus::Empty;
+        }
+        for (int i = current; i < params_.instances; ++i)
+        {
+            idle_.push_back(i);
+        }
+        wake_idle();
+    }
+
+    // Forget the wait and run-time distributions so far, so the result
+    // describes only what follows. Sketches merge but cannot be subtracted.
+    void reset_distributions()
+    {
+        for (InstanceDistributions &d : distributions_)
+        {
+            for (QuantileSketch &waits : d.waits_s)
+                waits.clear();
+            d.runs_s.clear();
+        }
+    }
+
+    // The bonus window has closed
+    [[nodiscard]] auto ended() const -> bool { return simulation_ended_; }
+
+    // Scale every role's generator waves, as a scenario `rate all` event does
+    void scale_arrivals(double factor)
+    {
+        std::scoped_lock lock(mutex_);
+        for (auto &scale : rate_scale_)
+            scale.store(factor, std::memory_order_relaxed);
+    }
+
+    // Replace the generator knobs; takes effect from the next generator tick.
+    // Safe to call from any thread while the simulation runs.
+    void set_generator(const GeneratorConfig &config)
+    {
+        std::scoped_lock lock(mutex_);
+        generator_ = config;
+    }
+
+    [[nodiscard]] auto result() const -> SimulationResult
+    {
+        SimulationResult r;
+        r.instances = instances_;
+        r.online_instances = static_cast<int>(std::count(offline_.begin(), offline_.end(), 0));
+        r.bonus_tanks_added = bonus_tanks_added_;
+        r.bonus_healers_added = bonus_healers_added_;
+        r.bonus_dps_added = bonus_dps_added_;
+        r.remaining_tanks = tanks_;
+        r.remaining_healers = healers_;
+        r.remaining_dps = dps_;
+        r.elapsed_ms = clock_.now();
+        r.bottleneck = bottleneck_;
+        r.distributions = distributions_;
+        r.regions = params_.regions;
+        r.idle_between_runs_ms = static_cast<double>(idle_between_us_) / 1000.0;
+        r.idle_between_runs_max_ms = static_cast<double>(idle_between_max_us_) / 1000.0;
+        r.handoffs = handoff_count_;
+        r.stages = stages_;
+        r.scenario_events = static_cast<int>(scenario_next_);
+        r.scenario_scripted = static_cast<int>(params_.scenario.size());
+        r.scenario_players = scenario_players_;
+        if (params_.closed_loop)
+        {
+            PlayerPopulation::RunStats runs = population_.run_stats();
+            r.population = PopulationStats{population_.size(), population_.memory_bytes(), runs.mean, runs.min,
+                                           runs.max};
+        }
+        if (latency_samples_ > 0)
+            r.mean_latency_ms = latency_sum_ms_ / static_cast<double>(latency_samples_);
+        r.samples = samples_.ordered();
+        r.samples_dropped = samples_.dropped();
+        return r;
+    }
+
+    // Current queue depths without taking the state lock
+    [[nodiscard]] auto probe() const -> QueueProbe
+    {
+        return QueueProbe{pub_tanks_.load(std::memory_order_relaxed),
+                          pub_healers_.load(std::memory_order_relaxed),
+                          pub_dps_.load(std::memory_order_relaxed),
+                          pub_active_.load(std::memory_order_relaxed),
+                          pub_formed_.load(std::memory_order_relaxed)};
+    }
+
+private:
+    struct Wave
+    {
+        int tanks = 0;
+        int healers = 0;
+        int dps = 0;
+    };
+
+    // Per-instance bookkeeping between two runs
+    struct Handoff
+    {
+        std::int64_t finished_us = -1; // end of the last run, -1 before the first
+        SimTime run_ends = 0;          // event driver: scheduled end of the current run
+        std::uint64_t runs = 0;        // runs started so far; numbers the RNG's duration draws
+        bool reserved = false;         // next party already taken out of the pools
+    };
+
+    // ---- state transitions shared by both drivers; caller holds mutex_ ----
+
+    [[nodiscard]] auto enough_players() const -> bool
+    {
+        const PartyTemplate &party = params_.party;
+        return (tanks_ >= party.tanks && healers_ >= party.healers && dps_ >= party.dps);
+    }
+
+    // Some instance could start a party right now
+    [[nodiscard]] auto can_form_party() const -> bool
+    {
+        return accepting_parties() && enough_players() && (!attribute_matching() || matchmaker_.any_ready());
+    }
+
+    // This instance could start a party right now
+    [[nodiscard]] auto can_form_party_for(int instance_id) const -> bool
+    {
+        return accepting_parties() && !offline_[instance_id] && enough_players() &&
+               (!attribute_matching() || matchmaker_.ready(instance_region(instance_id)));
+    }
+
+    // A closed population never runs out, so its queue is not drained after the end
+    [[nodiscard]] auto accepting_parties() const -> bool { return !params_.closed_loop || !simulation_ended_; }
+
+    [[nodiscard]] auto attribute_matching() const -> bool
+    {
+        return params_.rating_window > 0 || params_.regions > 1;
+    }
+
+    [[nodiscard]] auto instance_region(int instance_id) const -> int { return instance_id % params_.regions; }
+
+    [[nodiscard]] auto party_needs() const -> std::array<int, ROLE_COUNT>
+    {
+        return {params_.party.tanks, params_.party.healers, params_.party.dps};
+    }
+
+    [[nodiscard]] auto match_config() const -> MatchConfig
+    {
+        MatchConfig config;
+        config.rating_window = params_.rating_window;
+        config.max_latency_ms = params_.max_latency_ms;
+        config.regions = params_.regions;
+        config.region_penalty_ms = params_.region_penalty_ms;
+        config.relax_ms_per_s = params_.latency_relax_ms_per_s;
+        config.party = party_needs();
+        return config;
+    }
+
+    // Add `count` arrivals of one role to its queue
+    void enqueue(Role role, int count, SimTime now)
+    {
+        int r = static_cast<int>(role);
+        if (!attribute_matching())
+        {
+            queues_[r].push(now, count);
+            return;
+        }
+
+        // Matchmaking attributes: rating ~ U[1000, 2000]; latency to the home
+        // data center ~ U[10, 200] ms, or U[10, 60] ms when players are spread
+        // over several regions (remote regions add region_penalty_ms per hop)
+        int max_home_latency = params_.regions > 1 ? 60 : 200;
+        for (int i = 0; i < count; ++i)
+        {
+            PlayerAttributes attrs;
+            attrs.rating = rng_.uniform(1000, 2000);
+            attrs.region = rng_.uniform(0, params_.regions - 1);
+            attrs.latency_ms = rng_.uniform(10, max_home_latency);
+            matchmaker_.push(r, attrs, now);
+        }
+    }
+
+    void record_wait(int instance_id, int role, SimTime wait_ms)
+    {
+        distributions_[instance_id].waits_s[role].add(static_cast<double>(wait_ms) / 1000.0);
+    }
+
+    // Remove the members of the instance's next party from the queues, handing
+    // each member's wait, ending at `start_at`, to on_wait(role, wait_ms)
+    template <typename OnWait>
+    void dequeue_party(int instance_id, SimTime start_at, OnWait on_wait)
+    {
+        if (attribute_matching())
+        {
+            matchmaker_.take(instance_region(instance_id), start_at,
+                             [this, &on_wait](int role, SimTime wait_ms, int latency_ms)
+                             {
+                                 on_wait(role, wait_ms);
+                                 latency_sum_ms_ += latency_ms;
+                                 latency_samples_ += 1;
+                             });
+            matchmaker_.refresh(clock_.now());
+            return;
+        }
+
+        const auto need = party_needs();
+        if (params_.closed_loop)
+        {
+            // Members are kept as the instance's next party until it starts
+            PlayerPopulation::PlayerId *slot = &next_members_[instance_id * party_size()];
+            for (int r = 0; r < ROLE_COUNT; ++r)
+            {
+                for (int i = 0; i < need[r]; ++i)
+                {
+                    PlayerPopulation::PlayerId id = population_.dequeue(r);
+                    on_wait(r, start_at - population_.queued_since(id));
+                    *slot++ = id;
+                }
+            }
+            return;
+        }
+
+        for (int r = 0; r < ROLE_COUNT; ++r)
+        {
+            queues_[r].pop(need[r], start_at, [&on_wait, r](SimTime wait_ms)
+                           { on_wait(r, wait_ms); });
+        }
+    }
+
+    [[nodiscard]] auto party_size() const -> std::size_t
+    {
+        return static_cast<std::size_t>(params_.party.tanks) + params_.party.healers + params_.party.dps;
+    }
+
+    // Closed loop: the finished party's members start thinking and return later
+    void send_members_thinking(int instance_id)
+    {
+        if (!params_.closed_loop || simulation_ended_)
+            return;
+
+        SimTime now = clock_.now();
+        const PlayerPopulation::PlayerId *members = &members_[instance_id * party_size()];
+        for (std::size_t i = 0; i < party_size(); ++i)
+        {
+            SimTime return_at = now + draw_think_ms();
+            population_.think(members[i], return_at);
+            if constexpr (Clock::is_virtual)
+                schedule(return_at, EventKind::PlayerReturn);
+        }
+    }
+
+    // Exponential think time with mean think_ms
+    [[nodiscard]] auto draw_think_ms() -> SimTime
+    {
+        return static_cast<SimTime>(draw_exponential(params_.think_ms));
+    }
+
+    // Uniform on (0, 1]
+    template <typename Draws>
+    [[nodiscard]] static auto draw_unit(Draws &draws) -> double
+    {
+        constexpr int resolution = 1 << 30;
+        return static_cast<double>(draws.uniform(1, resolution)) / resolution;
+    }
+    [[nodiscard]] auto draw_unit() -> double { return draw_unit(rng_); }
+
+    template <typename Draws>
+    [[nodiscard]] static auto draw_exponential(double mean, Draws &draws) -> double
+    {
+        return -std::log(draw_unit(draws)) * mean;
+    }
+    [[nodiscard]] auto draw_exponential(double mean) -> double { return draw_exponential(mean, rng_); }
+
+    // Re-queue the thinking players who are due. Returns true if any came back.
+    auto release_returns() -> bool
+    {
+        if (!params_.closed_loop || simulation_ended_ || population_.next_return() > clock_.now())
+            return false;
+
+        account_bottleneck();
+        const std::array<int *, ROLE_COUNT> counts = {&tanks_, &healers_, &dps_};
+        population_.release_due(clock_.now(), [&counts](int role)
+                                { *counts[role] += 1; });
+        publish_counts();
+        return true;
+    }
+
+    void remove_party_players(int instance_id, SimTime start_at)
+    {
+        remove_party_players(instance_id, start_at, [this, instance_id](int role, SimTime wait_ms)
+                             { record_wait(instance_id, role, wait_ms); });
+    }
+
+    template <typename OnWait>
+    void remove_party_players(int instance_id, SimTime start_at, OnWait on_wait)
+    {
+        tanks_ -= params_.party.tanks;
+        healers_ -= params_.party.healers;
+        dps_ -= params_.party.dps;
+        dequeue_party(instance_id, start_at, on_wait);
+
+        // Queues are FIFO, so the initial players go first
+        if (initial_parties_left_ > 0)
+        {
+            if (--initial_parties_left_ == 0)
+                bottleneck_.initial_exhausted_ms = clock_.now();
+        }
+        else if (!simulation_ended_)
+        {
+            bottleneck_.bonus_parties += 1;
+        }
+    }
+
+    // Re-run matching when time alone can change the outcome (latency relaxation).
+    // Returns true if a party became available.
+    auto relax_matches() -> bool
+    {
+        if (!attribute_matching() || params_.latency_relax_ms_per_s == 0)
+            return false;
+        bool before = can_form_party();
+        matchmaker_.refresh(clock_.now());
+        return !before && can_form_party();
+    }
+
+    // Parties the current role pools could fill right now
+    [[nodiscard]] auto formable_parties() const -> int
+    {
+        const PartyTemplate &party = params_.party;
+        int parties = std::numeric_limits<int>::max();
+        if (party.tanks > 0)
+            parties = std::min(parties, tanks_ / party.tanks);
+        if (party.healers > 0)
+            parties = std::min(parties, healers_ / party.healers);
+        if (party.dps > 0)
+            parties = std::min(parties, dps_ / party.dps);
+        return parties;
+    }
+
+    // Role with the lowest available/required ratio
+    [[nodiscard]] auto scarcest_role() const -> Role
+    {
+        const PartyTemplate &party = params_.party;
+        const std::array<int, ROLE_COUNT> have = {tanks_, healers_, dps_};
+        const std::array<int, ROLE_COUNT> need = {party.tanks, party.healers, party.dps};
+        Role scarcest = Role::Tank;
+        double lowest = std::numeric_limits<double>::infinity();
+        for (int r = 0; r < ROLE_COUNT; ++r)
+        {
+            if (need[r] == 0)
+                continue;
+            double ratio = static_cast<double>(have[r]) / need[r];
+            if (ratio < lowest)
+            {
+                lowest = ratio;
+                scarcest = static_cast<Role>(r);
+            }
+        }
+        return scarcest;
+    }
+
+    // Online instances without a party. An offline instance waits for nothing;
+    // one still finishing its last run counts as active until it does.
+    [[nodiscard]] auto idle_instances() const -> int
+    {
+        int idle = params_.instances - active_instances_;
+        if (offline_count_ > 0)
+        {
+            idle -= static_cast<int>(std::count_if(instances_.begin(), instances_.end(), [](const Instance &inst)
+                                                   { return inst.status == InstanceStatus::Offline; }));
+        }
+        return idle;
+    }
+
+    // Charge the time since the last state change to whatever held throughput
+    // back during it. Called before every change to the role pools or instances.
+    void account_bottleneck()
+    {
+        SimTime now = clock_.now();
+        SimTime since = last_change_;
+        double dt = static_cast<double>(now - since) / 1000.0;
+        last_change_ = now;
+        if (simulation_ended_ || dt <= 0.0)
+            return;
+
+        int idle = idle_instances();
+        if (idle > 0 && !can_form_party())
+        {
+            bottleneck_.idle_instance_s[static_cast<int>(scarcest_role())] += idle * dt;
+            SimTime exhausted = bottleneck_.initial_exhausted_ms;
+            if (exhausted >= 0)
+            {
+                SimTime transition_end = exhausted + SimTime{params_.t1 + params_.t2} * 1000;
+                SimTime overlap = std::min(now, transition_end) - std::max(since, exhausted);
+                if (overlap > 0)
+                    bottleneck_.transition_idle_instance_s += idle * static_cast<double>(overlap) / 1000.0;
+            }
+        }
+        else if (idle == 0 && can_form_party())
+        {
+            double waiting = formable_parties() * dt;
+            bottleneck_.waiting_party_s += waiting;
+            if (initial_parties_left_ == 0)
+                bottleneck_.bonus_waiting_party_s += waiting;
+        }
+    }
+
+    // Mirror the counters for lock-free readers; caller holds mutex_
+    void publish_counts()
+    {
+        pub_tanks_.store(tanks_, std::memory_order_relaxed);
+        pub_healers_.store(healers_, std::memory_order_relaxed);
+        pub_dps_.store(dps_, std::memory_order_relaxed);
+        pub_active_.store(active_instances_, std::memory_order_relaxed);
+        pub_formed_.store(parties_formed_, std::memory_order_relaxed);
+    }
+
+    void end_simulation()
+    {
+        account_bottleneck();
+        simulation_ended_ = true;
+    }
+
+    // If the initial players ran out, or with bonus_lead_ms will run out
+    // within the lead, switch on bonus generation. Returns true on the transition.
+    auto activate_bonus_if_exhausted() -> bool
+    {
+        if (bonus_mode_active_)
+            return false;
+        bool exhausted = !can_form_party();
+        double forecast_ms = exhausted ? 0.0 : exhaustion_forecast_ms();
+        if (!exhausted && forecast_ms > params_.bonus_lead_ms)
+            return false;
+
+        bonus_mode_active_ = true;
+        bottleneck_.bonus_started_ms = clock_.now();
+        recent_starts_.clear();
+        if (exhausted)
+            log_.write("\n[SYSTEM] Initial players exhausted. Activating bonus player generation...\n\n");
+        else
+            log_.write("\n[SYSTEM] Initial players forecast to run out in ", static_cast<SimTime>(forecast_ms),
+                       "ms. Activating bonus player generation early...\n\n");
+        return true;
+    }
+
+    // Time until the initial players run out at the rate parties have been
+    // starting, or +inf without bonus_lead_ms or before any party started.
+    // The rate counts starts over the last mean run duration, which is about
+    // one per instance even while the burst at time 0 is in the window; it
+    // errs high early on, which only starts generation sooner.
+    auto exhaustion_forecast_ms() -> double
+    {
+        if (params_.bonus_lead_ms <= 0)
+            return std::numeric_limits<double>::infinity();
+        SimTime now = clock_.now();
+        SimTime window = std::max<SimTime>((params_.t1 + params_.t2) * 500, 1);
+        while (!recent_starts_.empty() && recent_starts_.front() <= now - window)
+            recent_starts_.pop_front();
+        if (recent_starts_.empty())
+            return std::numeric_limits<double>::infinity();
+        double parties_per_ms = static_cast<double>(recent_starts_.size()) / static_cast<double>(window);
+        return formable_parties() / parties_per_ms;
+    }
+
+    // Feed the forecast; only needed until bonus generation is on
+    void note_party_start()
+    {
+        if (params_.bonus_lead_ms > 0 && !bonus_mode_active_)
+            recent_starts_.push_back(clock_.now());
+    }
+
+    // Form party atomically, or start the one reserved during the previous run.
+    // Returns the run's index on this instance.
+    auto take_party(int instance_id) -> std::uint64_t
+    {
+        account_bottleneck();
+        Handoff &handoff = handoffs_[instance_id];
+        if (!handoff.reserved)
+            remove_party_players(instance_id, clock_.now());
+        handoff.reserved = false;
+        if (params_.closed_loop)
+        {
+            auto base = static_cast<std::ptrdiff_t>(instance_id * party_size());
+            std::copy_n(next_members_.begin() + base, party_size(), members_.begin() + base);
+        }
+
+        if (handoff.finished_us >= 0)
+        {
+            std::int64_t idle_us = clock_.now_us() - handoff.finished_us;
+            idle_between_us_ += idle_us;
+            idle_between_max_us_ = std::max(idle_between_max_us_, idle_us);
+            handoff_count_ += 1;
+        }
+
+        active_instances_ += 1;
+        parties_formed_ += 1;
+        note_party_start();
+        instances_[instance_id].status = InstanceStatus::Active;
+        publish_counts();
+        return handoff.runs++;
+    }
+
+    // Lookahead: set the instance's next party aside before its current run
+    // ends, so it can start the moment the run finishes. Returns true if reserved.
+    auto reserve_party(int instance_id, SimTime start_at) -> bool
+    {
+        if (params_.lookahead_ms == 0 || handoffs_[instance_id].reserved || !can_form_party_for(instance_id))
+            return false;
+
+        account_bottleneck();
+        remove_party_players(instance_id, start_at);
+        handoffs_[instance_id].reserved = true;
+        publish_counts();
+        return true;
+    }
+
+    // Status of an instance between runs
+    [[nodiscard]] auto resting_status(int instance_id) const -> InstanceStatus
+    {
+        return offline_[instance_id] ? InstanceStatus::Offline : InstanceStatus::Empty;
+    }
+
+    void finish_run(int instance_id, int duration)
+    {
+        account_bottleneck();
+        active_instances_ -= 1;
+        instances_[instance_id].served += 1;
+        instances_[instance_id].total_time += duration;
+        distributions_[instance_id].runs_s.add(duration);
+        instances_[instance_id].status = resting_status(instance_id);
+        handoffs_[instance_id].finished_us = clock_.now_us();
+        send_members_thinking(instance_id);
+        publish_counts();
+    }
+
+    void add_wave(const Wave &wave)
+    {
+        add_players(wave);
+
+        // Track bonus players added
+        bonus_tanks_added_ += wave.tanks;
+        bonus_healers_added_ += wave.healers;
+        bonus_dps_added_ += wave.dps;
+    }
+
+    void add_players(const Wave &wave)
+    {
+        account_bottleneck();
+        tanks_ += wave.tanks;
+        healers_ += wave.healers;
+        dps_ += wave.dps;
+
+        SimTime now = clock_.now();
+        if (params_.closed_loop)
+        {
+            // Scripted newcomers join the population and cycle like everyone else
+            population_.add(static_cast<int>(Role::Tank), wave.tanks, now);
+            population_.add(static_cast<int>(Role::Healer), wave.healers, now);
+            population_.add(static_cast<int>(Role::Dps), wave.dps, now);
+            publish_counts();
+            return;
+        }
+        enqueue(Role::Tank, wave.tanks, now);
+        enqueue(Role::Healer, wave.healers, now);
+        enqueue(Role::Dps, wave.dps, now);
+        if (attribute_matching())
+            matchmaker_.refresh(now);
+        publish_counts();
+    }
+
+    // ---- scenario events; caller holds mutex_ ----
+
+    [[nodiscard]] auto scenario_at(std::size_t index) const -> SimTime
+    {
+        return static_cast<SimTime>(std::llround(params_.scenario[index].at_s * 1000.0));
+    }
+
+    // Time of the next unapplied event, or SimTime max when the script is done
+    [[nodiscard]] auto next_scenario_at() const -> SimTime
+    {
+        return scenario_next_ < params_.scenario.size() ? scenario_at(scenario_next_)
+                                                        : std::numeric_limits<SimTime>::max();
+    }
+
+    // Apply every event due by now. Returns true if waiting instances should look again.
+    auto apply_scenario() -> bool
+    {
+        bool changed = false;
+        while (!simulation_ended_ && next_scenario_at() <= clock_.now())
+        {
+            changed = apply_scenario_event(params_.scenario[scenario_next_]) || changed;
+            ++scenario_next_;
+        }
+        return changed;
+    }
+
+    auto apply_scenario_event(const ScenarioEvent &event) -> bool
+    {
+        auto count = static_cast<int>(event.value);
+        switch (event.action)
+        {
+        case ScenarioEvent::Action::AddPlayers:
+        {
+            std::array<int, ROLE_COUNT> added{};
+            for (int r = 0; r < ROLE_COUNT; ++r)
+            {
+                if (event.role < 0 || event.role == r)
+                    added[r] = count;
+                scenario_players_[r] += added[r];
+            }
+            add_players(Wave{added[0], added[1], added[2]});
+            log_.write("[Scenario] Added players - Tanks: ", added[0], ", Healers: ", added[1],
+                       ", DPS: ", added[2], "\n");
+            return true;
+        }
+        case ScenarioEvent::Action::Offline:
+        {
+            // Highest ids first; a busy instance finishes its current run
+            int taken = 0;
+            for (int i = params_.instances - 1; i >= 0 && taken < count; --i)
+            {
+                if (offline_[i])
+                    continue;
+                offline_[i] = 1;
+                offline_count_ += 1;
+                if (instances_[i].status == InstanceStatus::Empty)
+                    instances_[i].status = InstanceStatus::Offline;
+                ++taken;
+            }
+            log_.write("[Scenario] ", taken, " instance(s) taken offline\n");
+            return false;
+        }
+        case ScenarioEvent::Action::Online:
+        {
+            int restored = 0;
+            for (int i = 0; i < params_.instances && restored < count; ++i)
+            {
+                if (!offline_[i])
+                    continue;
+                offline_[i] = 0;
+                offline_count_ -= 1;
+                if (instances_[i].status == InstanceStatus::Offline)
+                    instances_[i].status = InstanceStatus::Empty;
+                ++restored;
+            }
+            log_.write("[Scenario] ", restored, " instance(s) back online\n");
+            return restored > 0;
+        }
+        case ScenarioEvent::Action::Rate:
+            for (int r = 0; r < ROLE_COUNT; ++r)
+            {
+                if (event.role < 0 || event.role == r)
+                    rate_scale_[r].store(event.value, std::memory_order_relaxed);
+            }
+            log_.write("[Scenario] ",
+                       event.role < 0 ? std::string_view("All roles") : role_to_string(static_cast<Role>(event.role)),
+                       " arrival rate x", event.value, "\n");
+            return false;
+        }
+        return false;
+    }
+
+    // Format the status of every instance
+    void format_status(StatusLine &line) const
+    {
+        line.clear();
+        line.append("[Status] ");
+        for (int i = 0; i < params_.instances; ++i)
+        {
+            line.append_field<STATUS_FIELD_WIDTH>('I', i, ':', status_to_string(instances_[i].status));
+        }
+    }
+
+    // ---- generator (no lock needed) ----
+
+    // Random chance to generate players; an empty wave means nothing arrived
+    auto roll_wave(const GeneratorConfig &generator) -> Wave
+    {
+        return roll_wave(generator, rng_, next_arrival_ms_);
+    }
+
+    // Same, drawing from `draws` (anything with uniform(lo, hi)), with the
+    // arrival curve's next candidate kept in `next_arrival_ms`
+    template <typename Draws>
+    auto roll_wave(const GeneratorConfig &generator, Draws &draws, double &next_arrival_ms) -> Wave
+    {
+        Wave wave;
+        if (params_.closed_loop)
+            return wave;
+        if (params_.arrivals.active())
+        {
+            thin_arrivals(generator, draws, next_arrival_ms, wave);
+            return wave;
+        }
+        double roll = static_cast<double>(draws.uniform(0, 100)) / 100.0;
+        if (roll < generator.generation_probability)
+            draw_wave(generator, draws, wave);
+        return wave;
+    }
+
+    template <typename Draws>
+    void draw_wave(const GeneratorConfig &generator, Draws &draws, Wave &wave)
+    {
+        wave.tanks += scaled(Role::Tank, draws.uniform(generator.min_tanks_per_wave, generator.max_tanks_per_wave),
+                             draws);
+        wave.healers += scaled(Role::Healer,
+                               draws.uniform(generator.min_healers_per_wave, generator.max_healers_per_wave), draws);
+        wave.dps += scaled(Role::Dps, draws.uniform(generator.min_dps_per_wave, generator.max_dps_per_wave), draws);
+    }
+
+    // Apply a scenario's rate factor to a drawn count, rounding stochastically
+    // so the expected count scales exactly
+    template <typename Draws>
+    auto scaled(Role role, int count, Draws &draws) -> int
+    {
+        double scale = rate_scale_[static_cast<int>(role)].load(std::memory_order_relaxed);
+        if (scale == 1.0)
+            return count;
+        double target = count * scale;
+        double whole = std::floor(target);
+        return static_cast<int>(whole) + (draw_unit(draws) <= target - whole ? 1 : 0);
+    }
+
+    // Arrival curve: waves form a non-homogeneous Poisson process with rate
+    // probability / interval * multiplier(t). Candidates are drawn at the
+    // curve's bound rate and each is kept with probability multiplier / bound
+    // (Lewis-Shedler thinning), so no rate integral is ever inverted. Every
+    // kept candidate up to now joins this tick's wave.
+    template <typename Draws>
+    void thin_arrivals(const GeneratorConfig &generator, Draws &draws, double &next_arrival_ms, Wave &wave)
+    {
+        double bound = params_.arrivals.bound();
+        if (bound <= 0.0 || generator.generation_probability <= 0.0)
+            return;
+        double mean_gap_ms = generator.check_interval_ms / (generator.generation_probability * bound);
+        auto now = static_cast<double>(clock_.now());
+        if (next_arrival_ms < 0.0)
+            next_arrival_ms = now + draw_exponential(mean_gap_ms, draws);
+
+        while (next_arrival_ms <= now)
+        {
+            if (draw_unit(draws) * bound <= params_.arrivals.multiplier(next_arrival_ms / 1000.0))
+                draw_wave(generator, draws, wave);
+            next_arrival_ms += draw_exponential(mean_gap_ms, draws);
+        }
+    }
+
+    [[nodiscard]] auto draw_duration(int instance_id, std::uint64_t run) -> int
+    {
+        return rng_.duration(instance_id, run, params_.t1, params_.t2);
+    }
+
+    [[nodiscard]] auto bonus_elapsed(SimTime generator_start) const -> bool
+    {
+        return params_.bonus_duration > 0 &&
+               clock_.now() - generator_start >= SimTime{params_.bonus_duration} * 1000;
+    }
+
+    void log_wave(const Wave &wave)
+    {
+        log_.write("[Player Generator] Added players - ",
+                   "Tanks: ", wave.tanks,
+                   ", Healers: ", wave.healers,
+                   ", DPS: ", wave.dps, "\n");
+    }
+
+    void log_run(int instance_id, std::string_view event, int duration, const StatusLine &snapshot)
+    {
+        log_.write("[I", instance_id, "] Dungeon ", event, " (", duration, "s)\n", snapshot, '\n');
+    }
+
+    // Status-free variant for drivers where no thread sees the whole instance table
+    void log_event(int instance_id, std::string_view event, int duration)
+    {
+        log_.write("[I", instance_id, "] Dungeon ", event, " (", duration, "s)\n");
+    }
+
+    void log_bonus_ended()
+    {
+        if (params_.bonus_duration > 0)
+        {
+            log_.write("\n[SYSTEM] Bonus duration ended. Finishing remaining dungeons...\n\n");
+        }
+    }
+
+    // ---- parallel generators (wall clock) ----
+    //
+    // With generator_threads > 1 the driver's generator thread starts
+    // helpers that roll waves on the same schedule, so the arrival rate
+    // scales with the thread count. Each helper draws from its own Philox
+    // stream and every generator thread buffers its waves, handing them over
+    // generator_batch players at a time, so the shared state is touched once
+    // per batch rather than once per wave.
+
+    // A helper's own draws, so helpers never share an RNG counter
+    struct GeneratorStream
+    {
+        std::uint64_t key = 0;
+        std::uint32_t id = 0;
+        std::uint64_t draws = 0;
+
+        auto uniform(int lo, int hi) -> int { return philox_uniform(key, PhiloxStream::Generator, id, draws++, lo, hi); }
+    };
+
+    // Add `wave` to `buffer`, then hand the buffer to flush() once it holds
+    // generator_batch players, or if `drain` is set and it is not empty
+    template <typename Flush>
+    void buffer_wave(Wave &buffer, const Wave &wave, bool drain, Flush &flush)
+    {
+        buffer.tanks += wave.tanks;
+        buffer.healers += wave.healers;
+        buffer.dps += wave.dps;
+        int players = buffer.tanks + buffer.healers + buffer.dps;
+        if (players == 0 || (!drain && players < params_.generator_batch))
+            return;
+        flush(buffer);
+        buffer = Wave{};
+    }
+
+    // One helper: rolls waves until `stop`, then hands over what it holds.
+    // flush() runs on the helper's thread.
+    template <typename Flush>
+    void generator_helper_loop(int id, const std::atomic<bool> &stop, Flush flush)
+    {
+        GeneratorStream stream{params_.seed, static_cast<std::uint32_t>(id)};
+        double next_arrival_ms = -1.0;
+        Wave buffer;
+        while (!stop.load(std::memory_order_acquire))
+        {
+            GeneratorConfig generator;
+            {
+                std::scoped_lock lock(mutex_);
+                generator = generator_;
+            }
+            buffer_wave(buffer, roll_wave(generator, stream, next_arrival_ms), false, flush);
+            clock_.sleep_for(generator.check_interval_ms);
+        }
+        buffer_wave(buffer, Wave{}, true, flush);
+    }
+
+    template <typename Flush>
+    [[nodiscard]] auto start_generator_helpers(const std::atomic<bool> &stop, Flush flush) -> std::vector<std::thread>
+    {
+        std::vector<std::thread> helpers;
+        for (int id = 1; id < params_.generator_threads; ++id)
+            helpers.emplace_back([this, id, &stop, flush] { generator_helper_loop(id, stop, flush); });
+        return helpers;
+    }
+
+    // Returns once every helper has handed over its last batch
+    static void stop_generator_helpers(std::atomic<bool> &stop, std::vector<std::thread> &helpers)
+    {
+        stop.store(true, std::memory_order_release);
+        for (auto &helper : helpers)
+            helper.join();
+    }
+
+    // ---- threaded driver (wall clock) ----
+    //
+    // Idle instance threads list themselves in idle_ and park on their own
+    // Parker instead of sharing a condition variable, so a wave wakes only
+    // as many of them as it can fill parties for, oldest first, rather than
+    // every thread for one party.
+
+    // Lives only for the duration of run_threads(), so the engine stays copyable
+    struct WaitChannels
+    {
+        explicit WaitChannels(int count) : instances(count) {}
+
+        std::vector<Parker> instances;
+        Parker generator; // waits for bonus mode
+    };
+
+    // Idle instances chosen to wake, unparked after mutex_ is released
+    struct WakeList
+    {
+        std::array<int, MAX_INSTANCES> ids{};
+        int count = 0;
+    };
+
+    // Take the instances that can now start off idle_, oldest first: one per
+    // formable party, or all of them once the simulation has ended. A thread
+    // that loses the race for its party re-registers and parks again.
+    // Caller holds mutex_.
+    auto claim_idle() -> WakeList
+    {
+        WakeList woken;
+        // An upper bound: attribute matching may fill fewer parties
+        int budget = accepting_parties() ? formable_parties() : 0;
+        if (simulation_ended_)
+            budget = std::numeric_limits<int>::max();
+        std::size_t kept = 0;
+        for (int id : idle_)
+        {
+            if (simulation_ended_ || (budget > 0 && can_form_party_for(id)))
+            {
+                woken.ids[woken.count++] = id;
+                budget -= 1;
+            }
+            else
+            {
+                idle_[kept++] = id;
+            }
+        }
+        idle_.resize(kept);
+        return woken;
+    }
+
+    static void unpark(WaitChannels &waits, const WakeList &woken)
+    {
+        for (int i = 0; i < woken.count; ++i)
+            waits.instances[woken.ids[i]].unpark();
+    }
+
+    void instance_loop(WaitChannels &waits, int instance_id)
+    {
+        const int spins = params_.idle_spins >= 0 ? params_.idle_spins : Parker::default_spins();
+        StatusLine status_snapshot;    // state right after the current party started
+        StatusLine completed_snapshot;
+        bool reserved = false;         // current party was reserved during the previous run
+        std::uint64_t run = 0;
+
+        while (true)
+        {
+            // Try to form a party
+            if (!reserved)
+            {
+                std::unique_lock lock(mutex_);
+
+                // If can't form party and not in bonus mode yet, activate it
+                if (activate_bonus_if_exhausted())
+                {
+                    // Wake up the player generator thread
+                    waits.generator.unpark();
+                }
+
+                // Wait until a party can be formed or simulation ends. Only
+                // claim_idle() unparks us, and it takes us off idle_ first.
+                while (!can_form_party_for(instance_id) && !simulation_ended_)
+                {
+                    idle_.push_back(instance_id);
+                    lock.unlock();
+                    waits.instances[instance_id].park(spins);
+                    lock.lock();
+                }
+
+                if (simulation_ended_ && !can_form_party_for(instance_id))
+                {
+                    instances_[instance_id].status = resting_status(instance_id);
+                    break;
+                }
+
+                run = take_party(instance_id);
+
+                // Capture status snapshot while still holding the lock
+                if constexpr (Log::enabled)
+                    format_status(status_snapshot);
+            }
+
+            // Simulate dungeon run; with lookahead, reserve the next party near the end
+            int duration = draw_duration(instance_id, run);
+            log_run(instance_id, "started", duration, status_snapshot);
+
+            SimTime run_ms = SimTime{duration} * 1000;
+            SimTime lookahead = std::min<SimTime>(params_.lookahead_ms, run_ms);
+            clock_.sleep_for(run_ms - lookahead);
+            reserved = false;
+            if (lookahead > 0)
+            {
+                {
+                    std::scoped_lock lock(mutex_);
+                    reserved = reserve_party(instance_id, clock_.now() + lookahead);
+                }
+                clock_.sleep_for(lookahead);
+            }
+
+            // Update instance stats, and start the reserved party in the same critical section
+            {
+                std::unique_lock lock(mutex_);
+                finish_run(instance_id, duration);
+
+                if constexpr (Log::enabled)
+                    format_status(completed_snapshot);
+
+                if (reserved)
+                {
+                    run = take_party(instance_id);
+                    if constexpr (Log::enabled)
+                        format_status(status_snapshot);
+                }
+            }
+
+            log_run(instance_id, "completed", duration, completed_snapshot);
+        }
+    }
+
+    void player_generator_loop(WaitChannels &waits)
+    {
+        // Wait until bonus mode is activated
+        {
+            std::unique_lock lock(mutex_);
+            while (!bonus_mode_active_ && !simulation_ended_)
+            {
+                lock.unlock();
+                waits.generator.park(0);
+                lock.lock();
+            }
+            if (simulation_ended_)
+                return;
+        }
+
+        // Hand a batch of arrivals to the shared state and wake as many
+        // waiting instance threads as can now start
+        auto flush = [this, &waits](const Wave &batch)
+        {
+            WakeList woken;
+            {
+                std::scoped_lock lock(mutex_);
+                add_wave(batch);
+                woken = claim_idle();
+            }
+            log_wave(batch);
+            unpark(waits, woken);
+        };
+        std::atomic<bool> helpers_stop{false};
+        std::vector<std::thread> helpers = start_generator_helpers(helpers_stop, flush);
+        Wave buffer;
+
+        SimTime start_time = clock_.now();
+
+        while (true)
+        {
+            // Check if bonus duration has elapsed
+            if (bonus_elapsed(start_time))
+            {
+                stop_generator_helpers(helpers_stop, helpers);
+                buffer_wave(buffer, Wave{}, true, flush);
+
+                // Signal all threads to end
+                WakeList woken;
+                {
+                    std::unique_lock lock(mutex_);
+                    end_simulation();
+                    woken = claim_idle();
+                }
+                unpark(waits, woken);
+                break;
+            }
+
+            // Pick up hot-reloaded knobs
+            GeneratorConfig generator;
+            {
+                std::scoped_lock lock(mutex_);
+                generator = generator_;
+            }
+
+            // Waiting anchors may now qualify under a relaxed latency cap, and
+            // thinking players may be due back
+            WakeList woken;
+            SimTime next_return = 0;
+            {
+                std::scoped_lock lock(mutex_);
+                bool changed = relax_matches();
+                if (release_returns() || changed)
+                    woken = claim_idle();
+                next_return = population_.next_return();
+            }
+            unpark(waits, woken);
+
+            buffer_wave(buffer, roll_wave(generator), false, flush);
+
+            // Sleep before next check, or until the next player returns
+            SimTime sleep_ms = generator.check_interval_ms;
+            if (params_.closed_loop)
+                sleep_ms = std::clamp<SimTime>(next_return - clock_.now(), 0, sleep_ms);
+            clock_.sleep_for(sleep_ms);
+        }
+
+        log_bonus_ended();
+    }
+
+    // Applies scenario events as the clock reaches them. Sleeps at most
+    // SCENARIO_POLL_MS at a time so it notices the end promptly.
+    void scenario_loop(WaitChannels &waits)
+    {
+        constexpr SimTime SCENARIO_POLL_MS = 100;
+        while (true)
+        {
+            SimTime next = 0;
+            WakeList woken;
+            {
+                std::scoped_lock lock(mutex_);
+                if (simulation_ended_)
+                    return;
+                if (apply_scenario())
+                    woken = claim_idle();
+                next = next_scenario_at();
+            }
+            unpark(waits, woken);
+            if (next == std::numeric_limits<SimTime>::max())
+                return;
+            clock_.sleep_for(std::clamp<SimTime>(next - clock_.now(), 0, SCENARIO_POLL_MS));
+        }
+    }
+
+    // Records queue depth at a fixed period; reads only the published counters
+    void sampler_loop()
+    {
+        while (!sampler_stop_.load(std::memory_order_relaxed))
+        {
+            samples_.record(clock_.now(), probe());
+            clock_.sleep_for(params_.sample_interval_ms);
+        }
+    }
+
+    [[nodiscard]] auto start_sampler() -> std::thread
+    {
+        if (!samples_.enabled())
+            return {};
+        return std::thread(&Simulation::sampler_loop, this);
+    }
+
+    void stop_sampler(std::thread &sampler)
+    {
+        if (!sampler.joinable())
+            return;
+        sampler_stop_.store(true, std::memory_order_relaxed);
+        sampler.join();
+        samples_.record(clock_.now(), probe());
+    }
+
+    void run_threads()
+    {
+        static_assert(Lock::thread_safe, "the threaded driver needs a real lock policy");
+
+        std::thread sampler = start_sampler();
+        WaitChannels waits(params_.instances);
+
+        // Launch instance threads
+        std::vector<std::thread> instance_workers;
+        instance_workers.reserve(params_.instances);
+        for (int i = 0; i < params_.instances; ++i)
+        {
+            instance_workers.emplace_back(&Simulation::instance_loop, this, std::ref(waits), i);
+        }
+
+        // Launch player generator thread
+        std::thread player_gen(&Simulation::player_generator_loop, this, std::ref(waits));
+        std::thread injector;
+        if (!params_.scenario.empty())
+            injector = std::thread(&Simulation::scenario_loop, this, std::ref(waits));
+
+        // Wait for all instance threads to complete
+        for (auto &worker : instance_workers)
+        {
+            worker.join();
+        }
+
+        // If bonus mode was never activated or infinite mode, end simulation
+        {
+            std::scoped_lock lock(mutex_);
+            if (!simulation_ended_)
+                end_simulation();
+        }
+        waits.generator.unpark();
+
+        // Wait for player generator to finish
+        player_gen.join();
+        if (injector.joinable())
+            injector.join();
+        stop_sampler(sampler);
+    }
+
+    // ---- central matcher driver (wall clock, single writer) ----
+    //
+    // The matcher thread is the only one that touches the role pools and the
+    // instance table, so none of it is locked. Instance threads and the
+    // generator talk to it through a lock-free MPSC inbox; the matcher answers
+    // each instance through its own mailbox.
+
+    enum class MessageKind : std::uint8_t
+    {
+        InstanceFreed,
+        Arrivals,
+        Tick,
+        BonusEnded
+    };
+
+    struct MatcherMessage
+    {
+        MessageKind kind = MessageKind::Tick; // a default message is a clock tick
+        int instance_id = -1;
+        int duration = 0;
+        std::int64_t finished_us = 0; // InstanceFreed: when the run actually ended
+        Wave wave;
+    };
+
+    // Next run duration for one instance thread, or RETIRE; 0 = nothing yet
+    struct alignas(64) Mailbox
+    {
+        std::atomic<int> command{0};
+    };
+    static constexpr int RETIRE = -1;
+
+    enum class GeneratorSignal
+    {
+        Wait,
+        Go,
+        Stop
+    };
+
+    // Lives only for the duration of run_matcher(), so the engine stays copyable
+    struct MatcherChannels
+    {
+        explicit MatcherChannels(int instances)
+            : inbox(4 * static_cast<std::size_t>(instances) + 256), mailboxes(instances)
+        {
+        }
+
+        MpscQueue<MatcherMessage> inbox;
+        std::vector<Mailbox> mailboxes;
+        std::atomic<GeneratorSignal> generator{GeneratorSignal::Wait};
+        int retired = 0; // matcher thread only
+    };
+
+    void post(MatcherChannels &channels, int instance_id, int command)
+    {
+        std::atomic<int> &mailbox = channels.mailboxes[instance_id].command;
+        mailbox.store(command, std::memory_order_release);
+        mailbox.notify_one();
+    }
+
+    void signal_generator(MatcherChannels &channels, GeneratorSignal signal)
+    {
+        channels.generator.store(signal, std::memory_order_release);
+        channels.generator.notify_one();
+    }
+
+    // Matcher-side counterpart of try_start
+    void dispatch(MatcherChannels &channels, int instance_id)
+    {
+        if (activate_bonus_if_exhausted())
+            signal_generator(channels, GeneratorSignal::Go);
+
+        if (!can_form_party_for(instance_id))
+        {
+            if (simulation_ended_)
+            {
+                instances_[instance_id].status = resting_status(instance_id);
+                post(channels, instance_id, RETIRE);
+                channels.retired += 1;
+            }
+            else
+            {
+                idle_.push_back(instance_id);
+            }
+            return;
+        }
+
+        std::uint64_t run = take_party(instance_id);
+        int duration = draw_duration(instance_id, run);
+        post(channels, instance_id, duration);
+
+        if constexpr (Log::enabled)
+        {
+            StatusLine status_snapshot;
+            format_status(status_snapshot);
+            log_run(instance_id, "started", duration, status_snapshot);
+        }
+    }
+
+    void dispatch_idle(MatcherChannels &channels)
+    {
+        std::vector<int> waiting;
+        waiting.swap(idle_);
+        for (int id : waiting)
+        {
+            dispatch(channels, id);
+        }
+    }
+
+    void matcher_loop(MatcherChannels &channels)
+    {
+        // Closed loop: the generator keeps time from the start
+        if (bonus_mode_active_)
+            signal_generator(channels, GeneratorSignal::Go);
+
+        for (int i = 0; i < params_.instances; ++i)
+        {
+            dispatch(channels, i);
+        }
+
+        while (channels.retired < params_.instances)
+        {
+            MatcherMessage message;
+            channels.inbox.pop(message);
+
+            switch (message.kind)
+            {
+            case MessageKind::InstanceFreed:
+                finish_run(message.instance_id, message.duration);
+                handoffs_[message.instance_id].finished_us = message.finished_us;
+                if constexpr (Log::enabled)
+                {
+                    StatusLine status_snapshot;
+                    format_status(status_snapshot);
+                    log_run(message.instance_id, "completed", message.duration, status_snapshot);
+                }
+                dispatch(channels, message.instance_id);
+                break;
+            case MessageKind::Arrivals:
+                add_wave(message.wave);
+                dispatch_idle(channels);
+                break;
+            case MessageKind::Tick:
+            {
+                bool changed = relax_matches();
+                changed = release_returns() || changed;
+                if (changed)
+                    dispatch_idle(channels);
+                break;
+            }
+            case MessageKind::BonusEnded:
+                end_simulation();
+                log_bonus_ended();
+                dispatch_idle(channels);
+                break;
+            }
+        }
+    }
+
+    // Sleeps through each run the matcher hands out
+    void matcher_instance_loop(MatcherChannels &channels, int instance_id)
+    {
+        std::atomic<int> &mailbox = channels.mailboxes[instance_id].command;
+        while (true)
+        {
+            mailbox.wait(0, std::memory_order_acquire);
+            int duration = mailbox.exchange(0, std::memory_order_acquire);
+            if (duration == RETIRE)
+                break;
+
+            clock_.sleep_for(SimTime{duration} * 1000);
+
+            MatcherMessage done;
+            done.kind = MessageKind::InstanceFreed;
+            done.instance_id = instance_id;
+            done.duration = duration;
+            done.finished_us = clock_.now_us();
+            channels.inbox.push(done);
+        }
+    }
+
+    // Same schedule as player_generator_loop, but arrivals are messages
+    void matcher_generator_loop(MatcherChannels &channels)
+    {
+        channels.generator.wait(GeneratorSignal::Wait, std::memory_order_acquire);
+        if (channels.generator.load(std::memory_order_acquire) == GeneratorSignal::Stop)
+            return;
+
+        // Arrival batches are messages; the inbox takes several producers
+        auto flush = [this, &channels](const Wave &batch)
+        {
+            MatcherMessage arrivals;
+            arrivals.kind = MessageKind::Arrivals;
+            arrivals.wave = batch;
+            channels.inbox.push(arrivals);
+            log_wave(batch);
+        };
+        std::atomic<bool> helpers_stop{false};
+        std::vector<std::thread> helpers = start_generator_helpers(helpers_stop, flush);
+        Wave buffer;
+
+        SimTime start_time = clock_.now();
+        bool ticking = (attribute_matching() && params_.latency_relax_ms_per_s > 0) || params_.closed_loop;
+        while (true)
+        {
+            if (bonus_elapsed(start_time))
+            {
+                stop_generator_helpers(helpers_stop, helpers);
+                buffer_wave(buffer, Wave{}, true, flush);
+
+                MatcherMessage ended;
+                ended.kind = MessageKind::BonusEnded;
+                channels.inbox.push(ended);
+                break;
+            }
+
+            // Pick up hot-reloaded knobs
+            GeneratorConfig generator;
+            {
+                std::scoped_lock lock(mutex_);
+                generator = generator_;
+            }
+
+            if (ticking)
+                channels.inbox.push(MatcherMessage{});
+
+            buffer_wave(buffer, roll_wave(generator), false, flush);
+
+            clock_.sleep_for(generator.check_interval_ms);
+        }
+    }
+
+    void run_matcher()
+    {
+        static_assert(Lock::thread_safe, "the sampler and config reloads still need a real lock policy");
+
+        MatcherChannels channels(params_.instances);
+        std::thread sampler = start_sampler();
+
+        std::vector<std::thread> instance_workers;
+        instance_workers.reserve(params_.instances);
+        for (int i = 0; i < params_.instances; ++i)
+        {
+            instance_workers.emplace_back(&Simulation::matcher_instance_loop, this, std::ref(channels), i);
+        }
+        std::thread player_gen(&Simulation::matcher_generator_loop, this, std::ref(channels));
+
+        // The calling thread is the matcher
+        matcher_loop(channels);
+
+        for (auto &worker : instance_workers)
+        {
+            worker.join();
+        }
+        if (channels.generator.load(std::memory_order_acquire) == GeneratorSignal::Wait)
+            signal_generator(channels, GeneratorSignal::Stop);
+        player_gen.join();
+        stop_sampler(sampler);
+    }
+
+    // ---- pipeline driver (wall clock, Disruptor-style stages) ----
+    //
+    //   generator --arrivals--> match --parties--> dispatch --completions--> complete
+    //
+    // Every stage is the single writer of its own state: match owns the role
+    // pools, the dispatch stage is the pool of instance threads (each party is
+    // claimed by exactly one, which records its members' waits and its own
+    // status), and complete owns the other per-instance statistics.
+    // Match keeps at most `instances` parties between formation and completion
+    // by watching the complete stage's sequence.
+
+    struct ArrivalEvent
+    {
+        Wave wave;
+        bool bonus_ended = false;
+        std::int64_t published_us = 0;
+    };
+
+    struct PartyEvent
+    {
+        std::int64_t formed_us = 0;
+        bool retire = false; // tells the claiming instance thread to exit
+    };
+
+    // A party member's wait, carried beside the party's ring slot
+    struct MemberWait
+    {
+        int role = 0;
+        SimTime wait_ms = 0;
+    };
+
+    struct CompletionEvent
+    {
+        int instance_id = 0;
+        int duration = 0;
+        std::int64_t idle_us = -1; // gap since this instance's previous run, -1 on its first
+        std::int64_t finished_us = 0;
+    };
+
+    // Per-thread stage counters, merged after the threads are joined
+    struct StageCounter
+    {
+        long long events = 0;
+        std::int64_t latency_us = 0;
+
+        void add(std::int64_t latency)
+        {
+            events += 1;
+            latency_us += latency;
+        }
+    };
+
+    // Lives only for the duration of run_pipeline(), so the engine stays copyable
+    struct PipelineChannels
+    {
+        PipelineChannels(int instances, std::size_t party_size)
+            : arrivals(1024),
+              parties(2 * static_cast<std::size_t>(instances)),
+              completions(2 * static_cast<std::size_t>(instances)),
+              party_size(party_size),
+              waits(static_cast<std::size_t>(parties.capacity()) * party_size),
+              workers(instances),
+              dispatched(instances)
+        {
+        }
+
+        SingleProducerRing<ArrivalEvent> arrivals;
+        SingleProducerRing<PartyEvent> parties;
+        MultiProducerRing<CompletionEvent> completions;
+
+        // Members' waits of party `seq`, written by match before it publishes the party
+        [[nodiscard]] auto party_waits(std::int64_t seq) -> MemberWait *
+        {
+            return &waits[static_cast<std::size_t>(seq % parties.capacity()) * party_size];
+        }
+        std::size_t party_size;
+        std::vector<MemberWait> waits;
+
+        Sequence arrivals_read;                // last arrival the match stage consumed
+        std::vector<Sequence> workers;         // last party each instance thread finished reading
+        alignas(64) std::atomic<std::int64_t> next_claim{0}; // next party an instance thread may claim
+        Sequence completed;                    // last completion the complete stage accounted
+        alignas(64) std::atomic<std::int64_t> final_parties{-1}; // set by match once no more will form
+
+        Doorbell match_bell;    // arrivals published, completions accounted
+        Doorbell dispatch_bell; // parties published
+        Doorbell complete_bell; // completions published, final count set
+        std::atomic<GeneratorSignal> generator{GeneratorSignal::Wait};
+
+        StageCounter arrived, matched, completed_stats;
+        std::vector<StageCounter> dispatched; // per instance thread
+    };
+
+    // Arrival stage: the generator publishes waves instead of touching the pools
+    void pipeline_generator_loop(PipelineChannels &channels)
+    {
+        channels.generator.wait(GeneratorSignal::Wait, std::memory_order_acquire);
+        if (channels.generator.load(std::memory_order_acquire) == GeneratorSignal::Stop)
+            return;
+
+        SimTime start_time = clock_.now();
+        std::int64_t seq = 0;
+        auto publish = [&](const ArrivalEvent &event)
+        {
+            spin_until([&]
+                       { return seq - channels.arrivals.capacity() <= channels.arrivals_read.load(); });
+            channels.arrivals.slot(seq) = event;
+            channels.arrivals.publish(seq);
+            channels.match_bell.ring_one();
+            ++seq;
+        };
+
+        while (true)
+        {
+            if (bonus_elapsed(start_time))
+            {
+                ArrivalEvent ended;
+                ended.bonus_ended = true;
+                ended.published_us = clock_.now_us();
+                publish(ended);
+                break;
+            }
+
+            // Pick up hot-reloaded knobs
+            GeneratorConfig generator;
+            {
+                std::scoped_lock lock(mutex_);
+                generator = generator_;
+            }
+
+            Wave wave = roll_wave(generator);
+            if (wave.tanks > 0 || wave.healers > 0 || wave.dps > 0)
+            {
+                publish(ArrivalEvent{wave, false, clock_.now_us()});
+                channels.arrived.add(0);
+                log_wave(wave);
+            }
+
+            clock_.sleep_for(generator.check_interval_ms);
+        }
+    }
+
+    // Match stage: owns the role pools; runs on the calling thread
+    void pipeline_match_loop(PipelineChannels &channels)
+    {
+        std::int64_t next_arrival = 0;
+        std::int64_t next_party = 0;   // parties ring sequence, retire events included
+        std::int64_t seen_completed = -1;
+        long long formed = 0;
+        bool retiring = false;
+
+        // Wait until every instance thread is done reading the party, and its
+        // waits, that slot `next_party` reuses
+        auto claim_party_slot = [&]
+        {
+            std::int64_t wrap = next_party - channels.parties.capacity();
+            spin_until([&]
+                       {
+                           for (const Sequence &worker : channels.workers)
+                           {
+                               if (worker.load() < wrap)
+                                   return false;
+                           }
+                           return true;
+                       });
+        };
+        // Publish into the slot claim_party_slot() freed
+        auto publish_party = [&](const PartyEvent &event)
+        {
+            channels.parties.slot(next_party) = event;
+            channels.parties.publish(next_party);
+            ++next_party;
+            channels.dispatch_bell.ring_all();
+        };
+
+        while (!retiring || seen_completed < formed - 1)
+        {
+            std::uint32_t rung = channels.match_bell.snapshot();
+            bool progress = false;
+
+            // Completions free instance slots
+            std::int64_t completed = channels.completed.load();
+            if (completed != seen_completed)
+            {
+                account_bottleneck();
+                active_instances_ -= static_cast<int>(completed - seen_completed);
+                seen_completed = completed;
+                publish_counts();
+                progress = true;
+            }
+
+            while (next_arrival <= channels.arrivals.cursor())
+            {
+                ArrivalEvent event = channels.arrivals.slot(next_arrival);
+                channels.arrivals_read.store(next_arrival);
+                ++next_arrival;
+                progress = true;
+
+                if (event.bonus_ended)
+                {
+                    end_simulation();
+                    log_bonus_ended();
+                }
+                else
+                {
+                    channels.matched.latency_us += clock_.now_us() - event.published_us;
+                    add_wave(event.wave);
+                }
+            }
+
+            while (!retiring && active_instances_ < params_.instances)
+            {
+                if (activate_bonus_if_exhausted())
+                {
+                    channels.generator.store(GeneratorSignal::Go, std::memory_order_release);
+                    channels.generator.notify_one();
+                }
+                if (!can_form_party())
+                    break;
+
+                // No instance is known until one claims the party, so the waits
+                // travel with it; instance 0 only names the pipeline's one region
+                claim_party_slot();
+                account_bottleneck();
+                MemberWait *waits = channels.party_waits(next_party);
+                remove_party_players(0, clock_.now(), [&waits](int role, SimTime wait_ms)
+                                     { *waits++ = MemberWait{role, wait_ms}; });
+                active_instances_ += 1;
+                parties_formed_ += 1;
+                note_party_start();
+                publish_counts();
+                publish_party(PartyEvent{clock_.now_us(), false});
+                ++formed;
+                channels.matched.events += 1;
+                progress = true;
+            }
+
+            // No players will arrive any more: retire every instance thread
+            if (!retiring && simulation_ended_ && !can_form_party())
+            {
+                retiring = true;
+                for (int i = 0; i < params_.instances; ++i)
+                {
+                    claim_party_slot();
+                    publish_party(PartyEvent{0, true});
+                }
+                channels.final_parties.store(formed, std::memory_order_release);
+                channels.complete_bell.ring_one();
+                progress = true;
+            }
+
+            if (!progress)
+                channels.match_bell.wait(rung);
+        }
+    }
+
+    // Dispatch stage: each instance thread claims the next party, runs it and
+    // publishes the completion
+    void pipeline_instance_loop(PipelineChannels &channels, int instance_id)
+    {
+        Sequence &mine = channels.workers[instance_id];
+        StageCounter &stats = channels.dispatched[instance_id];
+        std::int64_t finished_us = -1;
+        std::uint64_t runs = 0;
+
+        while (true)
+        {
+            std::int64_t seq = channels.next_claim.fetch_add(1, std::memory_order_relaxed);
+            mine.store(seq - 1);
+            while (channels.parties.cursor() < seq)
+            {
+                std::uint32_t rung = channels.dispatch_bell.snapshot();
+                if (channels.parties.cursor() >= seq)
+                    break;
+                channels.dispatch_bell.wait(rung);
+            }
+            PartyEvent party = channels.parties.slot(seq);
+            if (!party.retire)
+            {
+                const MemberWait *waits = channels.party_waits(seq);
+                for (std::size_t i = 0; i < channels.party_size; ++i)
+                {
+                    record_wait(instance_id, waits[i].role, waits[i].wait_ms);
+                }
+            }
+            mine.store(seq);
+            if (party.retire)
+                break;
+
+            std::int64_t started_us = clock_.now_us();
+            stats.add(started_us - party.formed_us);
+            int duration = draw_duration(instance_id, runs++);
+            instances_[instance_id].status = InstanceStatus::Active;
+            log_event(instance_id, "started", duration);
+
+            clock_.sleep_for(SimTime{duration} * 1000);
+            instances_[instance_id].status = resting_status(instance_id);
+
+            CompletionEvent done;
+            done.instance_id = instance_id;
+            done.duration = duration;
+            done.idle_us = finished_us >= 0 ? started_us - finished_us : -1;
+            done.finished_us = clock_.now_us();
+            finished_us = done.finished_us;
+
+            std::int64_t slot = channels.completions.claim();
+            spin_until([&]
+                       { return slot - channels.completions.capacity() <= channels.completed.load(); });
+            channels.completions.slot(slot) = done;
+            channels.completions.publish(slot);
+            channels.complete_bell.ring_one();
+        }
+    }
+
+    // Complete stage: owns the per-instance statistics
+    void pipeline_complete_loop(PipelineChannels &channels)
+    {
+        std::int64_t next = 0;
+        while (true)
+        {
+            std::uint32_t rung = channels.complete_bell.snapshot();
+            std::int64_t final_parties = channels.final_parties.load(std::memory_order_acquire);
+            if (final_parties >= 0 && next == final_parties)
+                break;
+            if (!channels.completions.available(next))
+            {
+                channels.complete_bell.wait(rung);
+                continue;
+            }
+
+            CompletionEvent done = channels.completions.slot(next);
+            channels.completed_stats.add(clock_.now_us() - done.finished_us);
+
+            Instance &inst = instances_[done.instance_id];
+            inst.served += 1;
+            inst.total_time += done.duration;
+            distributions_[done.instance_id].runs_s.add(done.duration);
+            if (done.idle_us >= 0)
+            {
+                idle_between_us_ += done.idle_us;
+                idle_between_max_us_ = std::max(idle_between_max_us_, done.idle_us);
+                handoff_count_ += 1;
+            }
+            log_event(done.instance_id, "completed", done.duration);
+
+            channels.completed.store(next);
+            ++next;
+            channels.match_bell.ring_one();
+        }
+    }
+
+    void run_pipeline()
+    {
+        static_assert(Lock::thread_safe, "the sampler and config reloads still need a real lock policy");
+
+        PipelineChannels channels(params_.instances, party_size());
+        std::thread sampler = start_sampler();
+
+        std::vector<std::thread> instance_workers;
+        instance_workers.reserve(params_.instances);
+        for (int i = 0; i < params_.instances; ++i)
+        {
+            instance_workers.emplace_back(&Simulation::pipeline_instance_loop, this, std::ref(channels), i);
+        }
+        std::thread completer(&Simulation::pipeline_complete_loop, this, std::ref(channels));
+        std::thread player_gen(&Simulation::pipeline_generator_loop, this, std::ref(channels));
+
+        pipeline_match_loop(channels);
+
+        for (auto &worker : instance_workers)
+        {
+            worker.join();
+        }
+        completer.join();
+        if (channels.generator.load(std::memory_order_acquire) == GeneratorSignal::Wait)
+        {
+            channels.generator.store(GeneratorSignal::Stop, std::memory_order_release);
+            channels.generator.notify_one();
+        }
+        player_gen.join();
+        stop_sampler(sampler);
+
+        StageCounter dispatched;
+        for (const StageCounter &worker : channels.dispatched)
+        {
+            dispatched.events += worker.events;
+            dispatched.latency_us += worker.latency_us;
+        }
+        auto stage = [](std::string_view name, const StageCounter &counter, long long latency_events)
+        {
+            double latency = latency_events > 0
+                                 ? static_cast<double>(counter.latency_us) / static_cast<double>(latency_events)
+                                 : 0.0;
+            return StageStats{name, counter.events, latency};
+        };
+        stages_ = {stage("arrival", channels.arrived, 0),
+                   stage("match", channels.matched, channels.arrived.events),
+                   stage("dispatch", dispatched, dispatched.events),
+                   stage("complete", channels.completed_stats, channels.completed_stats.events)};
+    }
+
+    // ---- event-driven driver (virtual clock) ----
+
+    enum class EventKind
+    {
+        RunCompleted,
+        Reserve,
+        PlayerReturn,
+        Scenario,
+        GeneratorTick,
+        Sample
+    };
+
+    struct Event
+    {
+        SimTime time;
+        std::uint64_t seq; // tie-breaker keeps same-time events in FIFO order
+        EventKind kind;
+        int instance_id;
+        int duration;
+
+        auto operator>(const Event &other) const -> bool
+        {
+            return time != other.time ? time > other.time : seq > other.seq;
+        }
+    };
+
+    void schedule(SimTime time, EventKind kind, int instance_id = -1, int duration = 0)
+    {
+        events_.push(Event{time, next_seq_++, kind, instance_id, duration});
+    }
+
+    // Counterpart of one pass through instance_loop's locked section
+    void try_start(int instance_id)
+    {
+        if (activate_bonus_if_exhausted())
+        {
+            generator_start_ = clock_.now();
+            schedule(clock_.now(), EventKind::GeneratorTick);
+        }
+
+        if (!can_form_party_for(instance_id))
+        {
+            if (simulation_ended_)
+                instances_[instance_id].status = resting_status(instance_id);
+            else
+                idle_.push_back(instance_id);
+            return;
+        }
+
+        start_run(instance_id);
+    }
+
+    void start_run(int instance_id)
+    {
+        std::uint64_t run = take_party(instance_id);
+        int duration = draw_duration(instance_id, run);
+        SimTime ends = clock_.now() + SimTime{duration} * 1000;
+        schedule(ends, EventKind::RunCompleted, instance_id, duration);
+        if (params_.lookahead_ms > 0)
+        {
+            handoffs_[instance_id].run_ends = ends;
+            schedule(std::max(clock_.now(), ends - params_.lookahead_ms), EventKind::Reserve, instance_id);
+        }
+
+        if constexpr (Log::enabled)
+        {
+            StatusLine status_snapshot;
+            format_status(status_snapshot);
+            log_run(instance_id, "started", duration, status_snapshot);
+        }
+    }
+
+    // Give every waiting instance a chance to start, in the order they went idle
+    void wake_idle()
+    {
+        std::vector<int> waiting;
+        waiting.swap(idle_);
+        for (int id : waiting)
+        {
+            try_start(id);
+        }
+    }
+
+    void generator_tick()
+    {
+        if (bonus_elapsed(generator_start_))
+        {
+            end_simulation();
+            log_bonus_ended();
+            wake_idle();
+            return;
+        }
+
+        if (relax_matches())
+            wake_idle();
+
+        Wave wave = roll_wave(generator_);
+        if (wave.tanks > 0 || wave.healers > 0 || wave.dps > 0)
+        {
+            add_wave(wave);
+            log_wave(wave);
+            wake_idle();
+        }
+
+        schedule(clock_.now() + generator_.check_interval_ms, EventKind::GeneratorTick);
+    }
+
+    // Keeps sampling until the last instance has retired
+    void sample_tick()
+    {
+        samples_.record(clock_.now(), probe());
+        if (!simulation_ended_ || active_instances_ > 0)
+            schedule(clock_.now() + params_.sample_interval_ms, EventKind::Sample);
+    }
+
+    void start_events()
+    {
+        if (samples_.enabled())
+            schedule(0, EventKind::Sample);
+        // Closed loop: the generator keeps time from the start
+        if (bonus_mode_active_)
+            schedule(0, EventKind::GeneratorTick);
+        if (!params_.scenario.empty())
+            schedule(next_scenario_at(), EventKind::Scenario);
+
+        for (int i = 0; i < params_.instances; ++i)
+        {
+            try_start(i);
+        }
+    }
+
+    void run_events(SimTime until)
+    {
+        while (!events_.empty() && events_.top().time <= until)
+        {
+            Event event = events_.top();
+            events_.pop();
+            // Returns and scenario steps after the end would only stretch the clock
+            if ((event.kind == EventKind::PlayerReturn || event.kind == EventKind::Scenario) && simulation_ended_)
+                continue;
+            clock_.advance_to(event.time);
+
+            switch (event.kind)
+            {
+            case EventKind::RunCompleted:
+                finish_run(event.instance_id, event.duration);
+                if constexpr (Log::enabled)
+                {
+                    StatusLine status_snapshot;
+                    format_status(status_snapshot);
+                    log_run(event.instance_id, "completed", event.duration, status_snapshot);
+                }
+                if (handoffs_[event.instance_id].reserved)
+                    start_run(event.instance_id);
+                else
+                    try_start(event.instance_id);
+                break;
+            case EventKind::PlayerReturn:
+                if (release_returns())
+                    wake_idle();
+                break;
+            case EventKind::Scenario:
+                if (apply_scenario())
+                    wake_idle();
+                if (next_scenario_at() != std::numeric_limits<SimTime>::max())
+                    schedule(next_scenario_at(), EventKind::Scenario);
+                break;
+            case EventKind::Reserve:
+                reserve_party(event.instance_id, handoffs_[event.instance_id].run_ends);
+                break;
+            case EventKind::GeneratorTick:
+                generator_tick();
+                break;
+            case EventKind::Sample:
+                sample_tick();
+                break;
+            }
+        }
+    }
+
+    SimulationParams params_;
+
+    // Shared state
+    std::vector<Instance> instances_;
+    std::vector<InstanceDistributions> distributions_; // waits and run times, bounded however long the run
+    std::vector<Handoff> handoffs_;
+    int tanks_, healers_, dps_; // available players
+    int active_instances_ = 0;
+    long long parties_formed_ = 0;
+    GeneratorConfig generator_;
+    double next_arrival_ms_ = -1.0; // arrival curve: time of the next candidate wave, -1 = not drawn yet
+    typename Lock::mutex_type mutex_;
+
+    // Simulation control
+    bool simulation_ended_ = false;
+    bool bonus_mode_active_ = false;
+    int initial_parties_left_ = 0;      // parties the initial players can still fill
+    std::deque<SimTime> recent_starts_; // party starts within the last mean run, while bonus_lead_ms forecasts
+
+    // Arrival order per role, for wait-time measurement
+    std::array<ArrivalQueue, ROLE_COUNT> queues_;
+
+    // Attribute/region matching: per-player pools replace queues_
+    Matchmaker matchmaker_;
+    double latency_sum_ms_ = 0.0;
+    long long latency_samples_ = 0;
+
+    // Lock-free mirrors of the counters above, for the sampler
+    typename Lock::template published<int> pub_tanks_, pub_healers_, pub_dps_, pub_active_;
+    typename Lock::template published<long long> pub_formed_;
+    typename Lock::template published<bool> sampler_stop_;
+    SampleRing samples_;
+
+    // Bottleneck analysis
+    BottleneckStats bottleneck_;
+    SimTime last_change_ = 0;
+
+    // Instance idle time between consecutive runs
+    std::int64_t idle_between_us_ = 0;
+    std::int64_t idle_between_max_us_ = 0;
+    long long handoff_count_ = 0;
+    std::vector<StageStats> stages_;
+
+    // Scenario: next event to apply, instances taken offline, generator rate factors
+    std::size_t scenario_next_ = 0;
+    std::vector<char> offline_;
+    int offline_count_ = 0;
+    std::array<typename Lock::template published<double>, ROLE_COUNT> rate_scale_;
+    std::array<int, ROLE_COUNT> scenario_players_{};
+
+    // Closed loop: the population and each instance's current and next party
+    PlayerPopulation population_;
+    std::vector<PlayerPopulation::PlayerId> members_, next_members_;
+
+    // Bonus player tracking
+    int bonus_tanks_added_ = 0;
+    int bonus_healers_added_ = 0;
+    int bonus_dps_added_ = 0;
+
+    // Event-driven driver state
+    std::priority_queue<Event, std::vector<Event>, std::greater<>> events_;
+    std::uint64_t next_seq_ = 0;
+    std::vector<int> idle_; // instances waiting for a party, oldest first (shared-lock driver too)
+    SimTime generator_start_ = 0;
+    bool events_started_ = false;
+
+    [[no_unique_address]] Log log_;
+    [[no_unique_address]] Clock clock_;
+    Rng rng_;
+};
@@ -0,0 +1,56 @@
+#include "stats.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numeric>
+
+namespace
+{
+
+// 97.5th percentile of Student's t for 1..30 degrees of freedom
+constexpr std::array<double, 30> T_975 = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+
+auto t_975(std::size_t dof) -> double
+{
+    if (dof == 0)
+        return 0.0;
+    if (dof <= T_975.size())
+        return T_975[dof - 1];
+    return 1.960;
+}
+
+} // namespace
+
+auto mean(const std::vector<double> &values) -> double
+{
+    if (values.empty())
+        return 0.0;
+    return std::accumulate(values.begin(), values.end(), 0.0) / static_cast<double>(values.size());
+}
+
+auto confidence_95(const std::vector<double> &values) -> ConfidenceInterval
+{
+    ConfidenceInterval ci;
+    if (values.empty())
+        return ci;
+
+    ci.mean = mean(values);
+    auto [lo, hi] = std::minmax_element(values.begin(), values.end());
+    ci.min = *lo;
+    ci.max = *hi;
+    if (values.size() < 2)
+        return ci;
+
+    double sq = 0.0;
+    for (double v : values)
+    {
+        sq += (v - ci.mean) * (v - ci.mean);
+    }
+    double stddev = std::sqrt(sq / static_cast<double>(values.size() - 1));
+    ci.half_width = t_975(values.size() - 1) * stddev / std::sqrt(static_cast<double>(values.size()));
+    return ci;
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <vector>
+
+auto mean(const std::vector<double> &values) -> double;
+
+// Mean with a two-sided 95% Student-t confidence interval
+struct ConfidenceInterval
+{
+    double mean = 0.0;
+    double half_width = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+};
+
+auto confidence_95(const std::vector<double> &values) -> ConfidenceInterval;
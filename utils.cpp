@@ -1,7 +1,5 @@
 #include "utils.h"
 
-#include <utility>
-
 // Return a random integer in [lo, hi] inclusive range
 auto random_int(int lo, int hi) -> int
 {
@@ -10,9 +8,21 @@ auto random_int(int lo, int hi) -> int
   return dist(rng);
 }
 
-// Padding utility to align strings
-auto pad(const std::string &str, int width) -> std::string
+// Derive an independent 64-bit seed from (base, stream) via SplitMix64
+auto mix_seed(std::uint64_t base, std::uint64_t stream) -> std::uint64_t
+{
+  std::uint64_t z = base + (stream + 1) * 0x9E3779B97F4A7C15ULL;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+auto trim(std::string_view text) -> std::string_view
 {
-  if (std::cmp_greater_equal(str.size(), width)) return str;
-  return str + std::string(width - str.size(), ' ');
+  constexpr std::string_view whitespace = " \t\r";
+  auto first = text.find_first_not_of(whitespace);
+  if (first == std::string_view::npos)
+    return {};
+  auto last = text.find_last_not_of(whitespace);
+  return text.substr(first, last - first + 1);
 }
@@ -1,6 +1,20 @@
 #pragma once
+#include <charconv>
+#include <cstdint>
 #include <random>
-#include <string>
+#include <string_view>
+#include <system_error>
 
 auto random_int(int lo, int hi) -> int;
-auto pad(const std::string &str, int width) -> std::string;
\ No newline at end of file
+auto mix_seed(std::uint64_t base, std::uint64_t stream) -> std::uint64_t;
+
+// `text` without leading and trailing spaces, tabs and carriage returns
+auto trim(std::string_view text) -> std::string_view;
+
+// Parse all of `text` as a number; false if anything is left over
+template <typename T>
+auto parse_number(std::string_view text, T &out) -> bool
+{
+  auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), out);
+  return ec == std::errc{} && end == text.data() + text.size();
+}